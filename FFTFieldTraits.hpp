@@ -0,0 +1,153 @@
+// becgabri (10/17/2026)
+
+#ifndef FFTFIELDTRAITS_H
+#define FFTFIELDTRAITS_H
+
+#include "TemplateField.h"
+#include "ZpFFTRootTables.hpp"
+#include <stdint.h>
+#include <stdexcept>
+
+using namespace std;
+
+// unqualified calls so both NTL's power/inv and the global ZpFFTElement overloads
+// are visible, the traits below shadow these names
+template <class FieldType>
+inline FieldType fieldPower(const FieldType& a, long e) {
+    return power(a, e);
+}
+
+template <class FieldType>
+inline FieldType fieldInverse(const FieldType& a) {
+    return inv(a);
+}
+
+// NTL keeps the ZZ_p modulus per thread, so work handed to a pool thread has to
+// take it along: save() on the calling thread, restore() on the worker
+template <class FieldType>
+struct FieldThreadContext {
+    void save() {}
+    void restore() const {}
+};
+
+template <>
+struct FieldThreadContext<ZZ_p> {
+    ZZ_pContext context;
+    void save() { context.save(); }
+    void restore() const { context.restore(); }
+};
+
+// Everything OptimizedPSS needs to know about a field beyond +, -, * and ==.
+// The primary template works for any field type with NTL style power(a, long) and
+// inv(a), which covers ZZ_p initialized with *any* prime p where p-1 has enough
+// factors of 2. Faster backends specialize it (see ZpFFTElement below).
+template <class FieldType>
+struct FFTFieldTraits {
+    typedef FieldThreadContext<FieldType> ThreadContext;
+
+    // largest k such that 2^k | p-1, i.e. the largest supported transform is 2^k points
+    static int twoAdicity(long field_size) {
+        int k = 0;
+        long order = field_size - 1;
+        while (order > 0 && (order & 1) == 0) {
+            order >>= 1;
+            k++;
+        }
+        return k;
+    }
+
+    // a quadratic non-residue, so generator^((p-1)/2^k) has order exactly 2^k.
+    // 14 is kept for 3193032821761 since that's what the roots have always been
+    // built from; anything else searches for the smallest non-residue
+    static long multiplicativeGenerator(TemplateField<FieldType>* field, long field_size) {
+        if (field_size == 3193032821761) {
+            return 14;
+        }
+        FieldType minus_one = -field->GetElement(1);
+        for (long g = 2; g < field_size; g++) {
+            if (power(field->GetElement(g), (field_size - 1) / 2) == minus_one) {
+                return g;
+            }
+        }
+        throw invalid_argument("FFTFieldTraits: no quadratic non-residue, is the field size prime?");
+    }
+
+    // whether the roots of unity for field_size are the compile time ones in
+    // ZpFFTRootTables.hpp, i.e. rootOfUnity(log_size)^j = zpRootPower(j << (10 - log_size))
+    static bool fixedRoots(long field_size) {
+        return field_size == (long) ZpFFTElement::p;
+    }
+
+    // primitive 2^log_size-th root of unity
+    static FieldType rootOfUnity(TemplateField<FieldType>* field, long field_size, int log_size) {
+        if (log_size > twoAdicity(field_size)) {
+            throw invalid_argument("FFTFieldTraits: the field has no roots of unity of that order");
+        }
+        if (fixedRoots(field_size)) {
+            return fromWord(field, zpRootPower(1L << (zp_root_table_log - log_size)));
+        }
+        return power(field->GetElement(multiplicativeGenerator(field, field_size)), (field_size - 1) >> log_size);
+    }
+
+    static FieldType power(const FieldType& a, long e) {
+        return fieldPower(a, e);
+    }
+
+    static FieldType inverse(const FieldType& a) {
+        return fieldInverse(a);
+    }
+
+    // element I/O through the canonical representative in [0, p), requires p < 2^63
+    static uint64_t toWord(const FieldType& a);
+    static FieldType fromWord(TemplateField<FieldType>* field, uint64_t w) {
+        return field->GetElement((long) w);
+    }
+};
+
+template <>
+inline uint64_t FFTFieldTraits<ZZ_p>::toWord(const ZZ_p& a) {
+    return (uint64_t) to_long(rep(a));
+}
+
+// the native element only exists for one prime, so everything is fixed
+template <>
+struct FFTFieldTraits<ZpFFTElement> {
+    typedef FieldThreadContext<ZpFFTElement> ThreadContext;
+
+    static int twoAdicity(long field_size) {
+        return 10;
+    }
+
+    static long multiplicativeGenerator(TemplateField<ZpFFTElement>* field, long field_size) {
+        return 14;
+    }
+
+    static bool fixedRoots(long field_size) {
+        return true;
+    }
+
+    static ZpFFTElement rootOfUnity(TemplateField<ZpFFTElement>* field, long field_size, int log_size) {
+        if (log_size > 10) {
+            throw invalid_argument("FFTFieldTraits: the field has no roots of unity of that order");
+        }
+        return ZpFFTElement::fromCanonical(zpRootPower(1L << (zp_root_table_log - log_size)));
+    }
+
+    static ZpFFTElement power(const ZpFFTElement& a, long e) {
+        return ::power(a, e);
+    }
+
+    static ZpFFTElement inverse(const ZpFFTElement& a) {
+        return ::inv(a);
+    }
+
+    static uint64_t toWord(const ZpFFTElement& a) {
+        return a.elem;
+    }
+
+    static ZpFFTElement fromWord(TemplateField<ZpFFTElement>* field, uint64_t w) {
+        return ZpFFTElement::fromCanonical(w % ZpFFTElement::p);
+    }
+};
+
+#endif
@@ -22,7 +22,7 @@ int main() {
     auto t = 25;//125;//25;
     auto d = t + 2*l -1;
     auto num_parties = 100;//500;//100;
-    OptimizedPSS pss1(l,d,num_parties, field_size, &tempField);
+    OptimizedPSS<ZZ_p> pss1(l,d,num_parties, field_size, &tempField);
                  
     int nearest_pow = ceil(log2(num_parties+l));
     vector<ZZ_p> alpha_roots;
@@ -63,9 +63,21 @@ int main() {
     }
     pss1.setSecrets(sec);
     reg_pss1.setSecrets(sec);
+    TemplateField<ZpFFTElement> nativeField(field_size);
+    OptimizedPSS<ZpFFTElement> native_pss1(l,d,num_parties, field_size, &nativeField);
+    vector<ZpFFTElement> native_sec;
+    for (int j = 0; j < l; j++) {
+        native_sec.push_back(FFTFieldTraits<ZpFFTElement>::fromWord(&nativeField, FFTFieldTraits<ZZ_p>::toWord(sec[j])));
+    }
+    native_pss1.setSecrets(native_sec);
     int NUM_REPEATS = 10000;
     vector<nanoseconds> avg_reg_time(NUM_REPEATS);
     vector<nanoseconds> avg_opt_time(NUM_REPEATS); 
+    vector<nanoseconds> avg_native_time(NUM_REPEATS);
+    vector<nanoseconds> avg_opt_rec_time(NUM_REPEATS);
+    vector<nanoseconds> avg_native_rec_time(NUM_REPEATS);
+    auto opt_shares = pss1.secretShareValues();
+    auto native_shares = native_pss1.secretShareValues();
     for (int i = 0; i < NUM_REPEATS; i++) {
              
        steady_clock::time_point reg_start = steady_clock::now();
@@ -77,19 +89,52 @@ int main() {
        pss1.secretShareValues();
        steady_clock::time_point opt_end = steady_clock::now();
        avg_opt_time[i] = duration_cast<nanoseconds>(opt_end-opt_start);
+
+       steady_clock::time_point native_start = steady_clock::now();
+       native_pss1.secretShareValues();
+       steady_clock::time_point native_end = steady_clock::now();
+       avg_native_time[i] = duration_cast<nanoseconds>(native_end-native_start);
+
+       // recoverSS drops the check points from its input
+       vector<ZZ_p> opt_in(opt_shares.begin(), opt_shares.end());
+       steady_clock::time_point opt_rec_start = steady_clock::now();
+       pss1.recoverSS(opt_in);
+       steady_clock::time_point opt_rec_end = steady_clock::now();
+       avg_opt_rec_time[i] = duration_cast<nanoseconds>(opt_rec_end-opt_rec_start);
+
+       vector<ZpFFTElement> native_in(native_shares.begin(), native_shares.end());
+       steady_clock::time_point native_rec_start = steady_clock::now();
+       native_pss1.recoverSS(native_in);
+       steady_clock::time_point native_rec_end = steady_clock::now();
+       avg_native_rec_time[i] = duration_cast<nanoseconds>(native_rec_end-native_rec_start);
     
     }
     nanoseconds avg_reg(0);
     nanoseconds avg_opt(0);
+    nanoseconds avg_native(0);
+    nanoseconds avg_opt_rec(0);
+    nanoseconds avg_native_rec(0);
     for ( int j = 0; j < NUM_REPEATS; j++) {
         avg_reg += avg_reg_time[j];
         avg_opt += avg_opt_time[j];
+        avg_native += avg_native_time[j];
+        avg_opt_rec += avg_opt_rec_time[j];
+        avg_native_rec += avg_native_rec_time[j];
     }
     // do a sort 
     sort(avg_reg_time.begin(), avg_reg_time.end());
     sort(avg_opt_time.begin(), avg_opt_time.end());
+    sort(avg_native_time.begin(), avg_native_time.end());
+    sort(avg_opt_rec_time.begin(), avg_opt_rec_time.end());
+    sort(avg_native_rec_time.begin(), avg_native_rec_time.end());
     cout << "Avg reg. time: " << avg_reg.count()/NUM_REPEATS << endl;
     cout << "Avg opt. time: " << avg_opt.count()/NUM_REPEATS << endl;
+    cout << "Avg native opt. time: " << avg_native.count()/NUM_REPEATS << endl;
     cout << "Median reg. time: " << avg_reg_time[NUM_REPEATS/2].count() << endl;
     cout << "Median opt. time: " << avg_opt_time[NUM_REPEATS / 2].count() << endl;
+    cout << "Median native opt. time: " << avg_native_time[NUM_REPEATS / 2].count() << endl;
+    cout << "Avg opt. recover time: " << avg_opt_rec.count()/NUM_REPEATS << endl;
+    cout << "Avg native opt. recover time: " << avg_native_rec.count()/NUM_REPEATS << endl;
+    cout << "Median opt. recover time: " << avg_opt_rec_time[NUM_REPEATS / 2].count() << endl;
+    cout << "Median native opt. recover time: " << avg_native_rec_time[NUM_REPEATS / 2].count() << endl;
 }
@@ -0,0 +1,118 @@
+// becgabri (10/17/2026)
+
+#ifndef NTTCODELETS_H
+#define NTTCODELETS_H
+
+#include "NTTKernels.h"
+#include <algorithm>
+
+using namespace std;
+
+// Straight line DFTs for 2^3 ... 2^6 points. Everything that the loops in
+// OptimizedPSS::DFT work out at runtime (the bit reversal, block bases, twiddle
+// indices, and which twiddles are 1) is a template parameter here, so a codelet
+// compiles down to the loads, stores and field operations and nothing else.
+// Input in coefficient order, output p(w^0) ... p(w^(2^LOG-1)) in place. w is
+// laid out like TwiddleTable::forward, layer i reads w[2^i + k], and wq holds the
+// matching Shoup quotients for the fields that use them (see NTTKernels::mulTwiddle)
+
+template <int X, int BITS>
+struct CodeletBitReverse {
+    static const int value = ((X & 1) << (BITS-1)) | CodeletBitReverse<(X >> 1), BITS-1>::value;
+};
+
+template <int X>
+struct CodeletBitReverse<X, 0> {
+    static const int value = 0;
+};
+
+// swaps a[j] and a[rev(j)] for j <= J
+template <class FieldType, int LOG, int J>
+struct CodeletPermute {
+    static inline void run(FieldType* a) {
+        CodeletPermute<FieldType, LOG, J-1>::run(a);
+        const int r = CodeletBitReverse<J, LOG>::value;
+        if (J < r) {
+            swap(a[J], a[r]);
+        }
+    }
+};
+
+template <class FieldType, int LOG>
+struct CodeletPermute<FieldType, LOG, -1> {
+    static inline void run(FieldType* a) {}
+};
+
+// butterflies 0 ... J of layer I
+template <class FieldType, int I, int J>
+struct CodeletButterflies {
+    static const int h = 1 << I;
+    static const int k = J & (h-1);
+    static const int x = ((J >> I) << (I+1)) + k;
+
+    static inline void run(FieldType* a, const FieldType* w, const uint64_t* wq) {
+        CodeletButterflies<FieldType, I, J-1>::run(a, w, wq);
+        FieldType t = a[x+h];
+        // w^0 = 1, and wq is only there for fields with Shoup products
+        if (k != 0 && NTTKernels<FieldType>::has_lazy) {
+            NTTKernels<FieldType>::mulTwiddle(t, w[h+k], wq[h+k]);
+        } else if (k != 0) {
+            t *= w[h+k];
+        }
+        a[x+h] = a[x] - t;
+        a[x] += t;
+    }
+};
+
+template <class FieldType, int I>
+struct CodeletButterflies<FieldType, I, -1> {
+    static inline void run(FieldType* a, const FieldType* w, const uint64_t* wq) {}
+};
+
+// layers 0 ... I
+template <class FieldType, int LOG, int I>
+struct CodeletLayers {
+    static inline void run(FieldType* a, const FieldType* w, const uint64_t* wq) {
+        CodeletLayers<FieldType, LOG, I-1>::run(a, w, wq);
+        CodeletButterflies<FieldType, I, (1 << (LOG-1)) - 1>::run(a, w, wq);
+    }
+};
+
+template <class FieldType, int LOG>
+struct CodeletLayers<FieldType, LOG, -1> {
+    static inline void run(FieldType* a, const FieldType* w, const uint64_t* wq) {}
+};
+
+template <class FieldType, int LOG>
+struct NTTCodelet {
+    static void run(FieldType* a, const FieldType* w, const uint64_t* wq) {
+        CodeletPermute<FieldType, LOG, (1 << LOG) - 1>::run(a);
+        CodeletLayers<FieldType, LOG, LOG-1>::run(a, w, wq);
+    }
+};
+
+static const int min_codelet_log = 3;
+static const int max_codelet_log = 6;
+
+// false if there is no codelet for 2^log_size points
+template <class FieldType>
+bool runNTTCodelet(int log_size, FieldType* a, const FieldType* w, const uint64_t* wq) {
+    switch (log_size) {
+        case 3:
+            NTTCodelet<FieldType, 3>::run(a, w, wq);
+            return true;
+        case 4:
+            NTTCodelet<FieldType, 4>::run(a, w, wq);
+            return true;
+        case 5:
+            NTTCodelet<FieldType, 5>::run(a, w, wq);
+            return true;
+        case 6:
+            NTTCodelet<FieldType, 6>::run(a, w, wq);
+            return true;
+        default:
+            return false;
+    }
+}
+
+#endif
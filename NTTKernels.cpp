@@ -0,0 +1,668 @@
+// becgabri (10/17/2026)
+
+#include "NTTKernels.h"
+#include <stdexcept>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+static const uint64_t P = ZpFFTElement::p;
+
+static void butterflyScalar(uint64_t* x, uint64_t* y, const uint64_t* w, size_t len) {
+    for (size_t k = 0; k < len; k++) {
+        uint64_t t = ZpFFTElement::mulMod(w[k], y[k]);
+        uint64_t u = x[k];
+        x[k] = ZpFFTElement::addMod(u, t);
+        y[k] = ZpFFTElement::subMod(u, t);
+    }
+}
+
+static void pointwiseMultScalar(uint64_t* a, const uint64_t* b, size_t len) {
+    for (size_t k = 0; k < len; k++) {
+        a[k] = ZpFFTElement::mulMod(a[k], b[k]);
+    }
+}
+
+static inline void butterflyWord(uint64_t& x, uint64_t& y, uint64_t w) {
+    uint64_t t = ZpFFTElement::mulMod(w, y);
+    uint64_t u = x;
+    x = ZpFFTElement::addMod(u, t);
+    y = ZpFFTElement::subMod(u, t);
+}
+
+static inline void lazyButterflyWord(uint64_t& x, uint64_t& y, uint64_t w, uint64_t wq) {
+    const uint64_t two_p = 2*P;
+    uint64_t u = x;
+    u -= two_p & (0 - (uint64_t) (u >= two_p));
+    uint64_t t = ZpFFTElement::mulShoupLazy(w, wq, y);
+    x = u + t;
+    y = u - t + two_p;
+}
+
+static void lazyButterflyScalar(uint64_t* x, uint64_t* y, const uint64_t* w, const uint64_t* wq, size_t len) {
+    for (size_t k = 0; k < len; k++) {
+        lazyButterflyWord(x[k], y[k], w[k], wq[k]);
+    }
+}
+
+static void broadcastButterflyScalar(uint64_t* x, uint64_t* y, uint64_t w, size_t len) {
+    for (size_t k = 0; k < len; k++) {
+        butterflyWord(x[k], y[k], w);
+    }
+}
+
+static void lazyBroadcastButterflyScalar(uint64_t* x, uint64_t* y, uint64_t w, uint64_t wq, size_t len) {
+    for (size_t k = 0; k < len; k++) {
+        lazyButterflyWord(x[k], y[k], w, wq);
+    }
+}
+
+static void radix4ButterflyScalar(uint64_t* x0, uint64_t* x1, uint64_t* x2, uint64_t* x3,
+                                  const uint64_t* w1, const uint64_t* w2, const uint64_t* w3, size_t len) {
+    for (size_t k = 0; k < len; k++) {
+        uint64_t a0 = x0[k], a1 = x1[k], a2 = x2[k], a3 = x3[k];
+        butterflyWord(a0, a1, w1[k]);
+        butterflyWord(a2, a3, w1[k]);
+        butterflyWord(a0, a2, w2[k]);
+        butterflyWord(a1, a3, w3[k]);
+        x0[k] = a0;
+        x1[k] = a1;
+        x2[k] = a2;
+        x3[k] = a3;
+    }
+}
+
+static void lazyRadix4ButterflyScalar(uint64_t* x0, uint64_t* x1, uint64_t* x2, uint64_t* x3,
+                                      const uint64_t* w1, const uint64_t* w2, const uint64_t* w3,
+                                      const uint64_t* wq1, const uint64_t* wq2, const uint64_t* wq3, size_t len) {
+    for (size_t k = 0; k < len; k++) {
+        uint64_t a0 = x0[k], a1 = x1[k], a2 = x2[k], a3 = x3[k];
+        lazyButterflyWord(a0, a1, w1[k], wq1[k]);
+        lazyButterflyWord(a2, a3, w1[k], wq1[k]);
+        lazyButterflyWord(a0, a2, w2[k], wq2[k]);
+        lazyButterflyWord(a1, a3, w3[k], wq3[k]);
+        x0[k] = a0;
+        x1[k] = a1;
+        x2[k] = a2;
+        x3[k] = a3;
+    }
+}
+
+static void normalizeScalar(uint64_t* a, size_t len) {
+    const uint64_t two_p = 2*P;
+    for (size_t k = 0; k < len; k++) {
+        uint64_t u = a[k];
+        u -= two_p & (0 - (uint64_t) (u >= two_p));
+        u -= P & (0 - (uint64_t) (u >= P));
+        a[k] = u;
+    }
+}
+
+static void gsButterflyScalar(uint64_t* x, uint64_t* y, const uint64_t* w, size_t len) {
+    for (size_t k = 0; k < len; k++) {
+        uint64_t u = x[k];
+        uint64_t v = y[k];
+        x[k] = ZpFFTElement::addMod(u, v);
+        y[k] = ZpFFTElement::mulMod(w[k], ZpFFTElement::subMod(u, v));
+    }
+}
+
+static void lazyGSButterflyScalar(uint64_t* x, uint64_t* y, const uint64_t* w, const uint64_t* wq, size_t len) {
+    const uint64_t two_p = 2*P;
+    for (size_t k = 0; k < len; k++) {
+        uint64_t u = x[k];
+        uint64_t v = y[k];
+        uint64_t s = u + v;
+        x[k] = s - (two_p & (0 - (uint64_t) (s >= two_p)));
+        y[k] = ZpFFTElement::mulShoupLazy(w[k], wq[k], u - v + two_p);
+    }
+}
+
+#ifdef __x86_64__
+
+// ---------------------------------------------------------------------------
+// AVX2: no 64x64 bit multiply, so the quotient floor(a*b/p) is estimated in
+// double precision (off by at most one since a*b/p < 2^42) and the remainder
+// a*b - q*p is computed exactly mod 2^64 out of 32x32 bit products
+// ---------------------------------------------------------------------------
+
+// exact conversion of x < 2^52 to double: or in the exponent of 2^52 and subtract it
+__attribute__((target("avx2")))
+static inline __m256d avx2ToDouble(__m256i x) {
+    const __m256i magic = _mm256_set1_epi64x(0x4330000000000000LL);
+    return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(x, magic)), _mm256_castsi256_pd(magic));
+}
+
+// exact conversion of an integer valued double 0 <= x < 2^52 back to 64 bits
+__attribute__((target("avx2")))
+static inline __m256i avx2ToInt(__m256d x) {
+    const __m256i magic = _mm256_set1_epi64x(0x4330000000000000LL);
+    return _mm256_xor_si256(_mm256_castpd_si256(_mm256_add_pd(x, _mm256_castsi256_pd(magic))), magic);
+}
+
+// low 64 bits of a*b
+__attribute__((target("avx2")))
+static inline __m256i avx2MulLo64(__m256i a, __m256i b) {
+    __m256i lo = _mm256_mul_epu32(a, b);
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                     _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i avx2MulMod(__m256i a, __m256i b) {
+    const __m256i p = _mm256_set1_epi64x((long long) P);
+    const __m256i p_minus_one = _mm256_set1_epi64x((long long) P - 1);
+    const __m256d p_inv = _mm256_set1_pd(1.0 / (double) P);
+    const __m256i zero = _mm256_setzero_si256();
+
+    __m256d prod = _mm256_mul_pd(avx2ToDouble(a), avx2ToDouble(b));
+    __m256i q = avx2ToInt(_mm256_floor_pd(_mm256_mul_pd(prod, p_inv)));
+    // r in [-p, 2p)
+    __m256i r = _mm256_sub_epi64(avx2MulLo64(a, b), avx2MulLo64(q, p));
+    r = _mm256_add_epi64(r, _mm256_and_si256(_mm256_cmpgt_epi64(zero, r), p));
+    r = _mm256_sub_epi64(r, _mm256_and_si256(_mm256_cmpgt_epi64(r, p_minus_one), p));
+    return r;
+}
+
+__attribute__((target("avx2")))
+static inline void avx2Butterfly(__m256i& x, __m256i& y, __m256i w) {
+    const __m256i p = _mm256_set1_epi64x((long long) P);
+    const __m256i p_minus_one = _mm256_set1_epi64x((long long) P - 1);
+    __m256i t = avx2MulMod(w, y);
+    __m256i s = _mm256_add_epi64(x, t);
+    s = _mm256_sub_epi64(s, _mm256_and_si256(_mm256_cmpgt_epi64(s, p_minus_one), p));
+    __m256i d = _mm256_sub_epi64(x, t);
+    y = _mm256_add_epi64(d, _mm256_and_si256(_mm256_cmpgt_epi64(t, x), p));
+    x = s;
+}
+
+__attribute__((target("avx2")))
+static void butterflyAVX2(uint64_t* x, uint64_t* y, const uint64_t* w, size_t len) {
+    size_t k = 0;
+    for (; k + 4 <= len; k += 4) {
+        __m256i xv = _mm256_loadu_si256((const __m256i*) (x + k));
+        __m256i yv = _mm256_loadu_si256((const __m256i*) (y + k));
+        __m256i wv = _mm256_loadu_si256((const __m256i*) (w + k));
+        avx2Butterfly(xv, yv, wv);
+        _mm256_storeu_si256((__m256i*) (x + k), xv);
+        _mm256_storeu_si256((__m256i*) (y + k), yv);
+    }
+    butterflyScalar(x + k, y + k, w + k, len - k);
+}
+
+__attribute__((target("avx2")))
+static void pointwiseMultAVX2(uint64_t* a, const uint64_t* b, size_t len) {
+    size_t k = 0;
+    for (; k + 4 <= len; k += 4) {
+        __m256i av = _mm256_loadu_si256((const __m256i*) (a + k));
+        __m256i bv = _mm256_loadu_si256((const __m256i*) (b + k));
+        _mm256_storeu_si256((__m256i*) (a + k), avx2MulMod(av, bv));
+    }
+    pointwiseMultScalar(a + k, b + k, len - k);
+}
+
+// Shoup product w*y in [0, 2p) for y < 2^44. The 52 bit quotient wq*y >> 52 is put
+// together from 32 bit halves wq = w1*2^32 + w0 (w1 < 2^20), y = y1*2^32 + y0
+// (y1 < 2^12): wq*y >> 52 = (w1*y1 << 12) + ((w1*y0 + w0*y1 + (w0*y0 >> 32)) >> 20)
+__attribute__((target("avx2")))
+static inline __m256i avx2MulShoupLazy(__m256i w, __m256i wq, __m256i y) {
+    const __m256i p = _mm256_set1_epi64x((long long) P);
+    __m256i wq_hi = _mm256_srli_epi64(wq, 32);
+    __m256i y_hi = _mm256_srli_epi64(y, 32);
+    __m256i mid = _mm256_add_epi64(_mm256_mul_epu32(wq_hi, y), _mm256_mul_epu32(wq, y_hi));
+    mid = _mm256_add_epi64(mid, _mm256_srli_epi64(_mm256_mul_epu32(wq, y), 32));
+    __m256i q = _mm256_add_epi64(_mm256_slli_epi64(_mm256_mul_epu32(wq_hi, y_hi), 12), _mm256_srli_epi64(mid, 20));
+    return _mm256_sub_epi64(avx2MulLo64(w, y), avx2MulLo64(q, p));
+}
+
+__attribute__((target("avx2")))
+static inline void avx2LazyButterfly(__m256i& x, __m256i& y, __m256i w, __m256i wq) {
+    const __m256i two_p = _mm256_set1_epi64x(2*(long long) P);
+    const __m256i two_p_minus_one = _mm256_set1_epi64x(2*(long long) P - 1);
+    __m256i u = _mm256_sub_epi64(x, _mm256_and_si256(_mm256_cmpgt_epi64(x, two_p_minus_one), two_p));
+    __m256i t = avx2MulShoupLazy(w, wq, y);
+    x = _mm256_add_epi64(u, t);
+    y = _mm256_add_epi64(_mm256_sub_epi64(u, t), two_p);
+}
+
+__attribute__((target("avx2")))
+static void lazyButterflyAVX2(uint64_t* x, uint64_t* y, const uint64_t* w, const uint64_t* wq, size_t len) {
+    size_t k = 0;
+    for (; k + 4 <= len; k += 4) {
+        __m256i xv = _mm256_loadu_si256((const __m256i*) (x + k));
+        __m256i yv = _mm256_loadu_si256((const __m256i*) (y + k));
+        __m256i wv = _mm256_loadu_si256((const __m256i*) (w + k));
+        __m256i wqv = _mm256_loadu_si256((const __m256i*) (wq + k));
+        avx2LazyButterfly(xv, yv, wv, wqv);
+        _mm256_storeu_si256((__m256i*) (x + k), xv);
+        _mm256_storeu_si256((__m256i*) (y + k), yv);
+    }
+    lazyButterflyScalar(x + k, y + k, w + k, wq + k, len - k);
+}
+
+__attribute__((target("avx2")))
+static void broadcastButterflyAVX2(uint64_t* x, uint64_t* y, uint64_t w, size_t len) {
+    const __m256i wv = _mm256_set1_epi64x((long long) w);
+    size_t k = 0;
+    for (; k + 4 <= len; k += 4) {
+        __m256i xv = _mm256_loadu_si256((const __m256i*) (x + k));
+        __m256i yv = _mm256_loadu_si256((const __m256i*) (y + k));
+        avx2Butterfly(xv, yv, wv);
+        _mm256_storeu_si256((__m256i*) (x + k), xv);
+        _mm256_storeu_si256((__m256i*) (y + k), yv);
+    }
+    broadcastButterflyScalar(x + k, y + k, w, len - k);
+}
+
+__attribute__((target("avx2")))
+static void lazyBroadcastButterflyAVX2(uint64_t* x, uint64_t* y, uint64_t w, uint64_t wq, size_t len) {
+    const __m256i wv = _mm256_set1_epi64x((long long) w);
+    const __m256i wqv = _mm256_set1_epi64x((long long) wq);
+    size_t k = 0;
+    for (; k + 4 <= len; k += 4) {
+        __m256i xv = _mm256_loadu_si256((const __m256i*) (x + k));
+        __m256i yv = _mm256_loadu_si256((const __m256i*) (y + k));
+        avx2LazyButterfly(xv, yv, wv, wqv);
+        _mm256_storeu_si256((__m256i*) (x + k), xv);
+        _mm256_storeu_si256((__m256i*) (y + k), yv);
+    }
+    lazyBroadcastButterflyScalar(x + k, y + k, w, wq, len - k);
+}
+
+// two decimation in time layers per load/store, the blocks x0|x1 and x2|x3 with w1,
+// then x0|x2 with w2 and x1|x3 with w3
+__attribute__((target("avx2")))
+static void radix4ButterflyAVX2(uint64_t* x0, uint64_t* x1, uint64_t* x2, uint64_t* x3,
+                                const uint64_t* w1, const uint64_t* w2, const uint64_t* w3, size_t len) {
+    size_t k = 0;
+    for (; k + 4 <= len; k += 4) {
+        __m256i a0 = _mm256_loadu_si256((const __m256i*) (x0 + k));
+        __m256i a1 = _mm256_loadu_si256((const __m256i*) (x1 + k));
+        __m256i a2 = _mm256_loadu_si256((const __m256i*) (x2 + k));
+        __m256i a3 = _mm256_loadu_si256((const __m256i*) (x3 + k));
+        __m256i v1 = _mm256_loadu_si256((const __m256i*) (w1 + k));
+        avx2Butterfly(a0, a1, v1);
+        avx2Butterfly(a2, a3, v1);
+        avx2Butterfly(a0, a2, _mm256_loadu_si256((const __m256i*) (w2 + k)));
+        avx2Butterfly(a1, a3, _mm256_loadu_si256((const __m256i*) (w3 + k)));
+        _mm256_storeu_si256((__m256i*) (x0 + k), a0);
+        _mm256_storeu_si256((__m256i*) (x1 + k), a1);
+        _mm256_storeu_si256((__m256i*) (x2 + k), a2);
+        _mm256_storeu_si256((__m256i*) (x3 + k), a3);
+    }
+    radix4ButterflyScalar(x0 + k, x1 + k, x2 + k, x3 + k, w1 + k, w2 + k, w3 + k, len - k);
+}
+
+__attribute__((target("avx2")))
+static void lazyRadix4ButterflyAVX2(uint64_t* x0, uint64_t* x1, uint64_t* x2, uint64_t* x3,
+                                    const uint64_t* w1, const uint64_t* w2, const uint64_t* w3,
+                                    const uint64_t* wq1, const uint64_t* wq2, const uint64_t* wq3, size_t len) {
+    size_t k = 0;
+    for (; k + 4 <= len; k += 4) {
+        __m256i a0 = _mm256_loadu_si256((const __m256i*) (x0 + k));
+        __m256i a1 = _mm256_loadu_si256((const __m256i*) (x1 + k));
+        __m256i a2 = _mm256_loadu_si256((const __m256i*) (x2 + k));
+        __m256i a3 = _mm256_loadu_si256((const __m256i*) (x3 + k));
+        __m256i v1 = _mm256_loadu_si256((const __m256i*) (w1 + k));
+        __m256i q1 = _mm256_loadu_si256((const __m256i*) (wq1 + k));
+        avx2LazyButterfly(a0, a1, v1, q1);
+        avx2LazyButterfly(a2, a3, v1, q1);
+        avx2LazyButterfly(a0, a2, _mm256_loadu_si256((const __m256i*) (w2 + k)), _mm256_loadu_si256((const __m256i*) (wq2 + k)));
+        avx2LazyButterfly(a1, a3, _mm256_loadu_si256((const __m256i*) (w3 + k)), _mm256_loadu_si256((const __m256i*) (wq3 + k)));
+        _mm256_storeu_si256((__m256i*) (x0 + k), a0);
+        _mm256_storeu_si256((__m256i*) (x1 + k), a1);
+        _mm256_storeu_si256((__m256i*) (x2 + k), a2);
+        _mm256_storeu_si256((__m256i*) (x3 + k), a3);
+    }
+    lazyRadix4ButterflyScalar(x0 + k, x1 + k, x2 + k, x3 + k, w1 + k, w2 + k, w3 + k, wq1 + k, wq2 + k, wq3 + k, len - k);
+}
+
+__attribute__((target("avx2")))
+static void normalizeAVX2(uint64_t* a, size_t len) {
+    const __m256i p = _mm256_set1_epi64x((long long) P);
+    const __m256i p_minus_one = _mm256_set1_epi64x((long long) P - 1);
+    const __m256i two_p = _mm256_set1_epi64x(2*(long long) P);
+    const __m256i two_p_minus_one = _mm256_set1_epi64x(2*(long long) P - 1);
+    size_t k = 0;
+    for (; k + 4 <= len; k += 4) {
+        __m256i av = _mm256_loadu_si256((const __m256i*) (a + k));
+        av = _mm256_sub_epi64(av, _mm256_and_si256(_mm256_cmpgt_epi64(av, two_p_minus_one), two_p));
+        av = _mm256_sub_epi64(av, _mm256_and_si256(_mm256_cmpgt_epi64(av, p_minus_one), p));
+        _mm256_storeu_si256((__m256i*) (a + k), av);
+    }
+    normalizeScalar(a + k, len - k);
+}
+
+__attribute__((target("avx2")))
+static void gsButterflyAVX2(uint64_t* x, uint64_t* y, const uint64_t* w, size_t len) {
+    const __m256i p = _mm256_set1_epi64x((long long) P);
+    const __m256i p_minus_one = _mm256_set1_epi64x((long long) P - 1);
+    size_t k = 0;
+    for (; k + 4 <= len; k += 4) {
+        __m256i xv = _mm256_loadu_si256((const __m256i*) (x + k));
+        __m256i yv = _mm256_loadu_si256((const __m256i*) (y + k));
+        __m256i wv = _mm256_loadu_si256((const __m256i*) (w + k));
+        __m256i s = _mm256_add_epi64(xv, yv);
+        s = _mm256_sub_epi64(s, _mm256_and_si256(_mm256_cmpgt_epi64(s, p_minus_one), p));
+        __m256i d = _mm256_sub_epi64(xv, yv);
+        d = _mm256_add_epi64(d, _mm256_and_si256(_mm256_cmpgt_epi64(yv, xv), p));
+        _mm256_storeu_si256((__m256i*) (x + k), s);
+        _mm256_storeu_si256((__m256i*) (y + k), avx2MulMod(wv, d));
+    }
+    gsButterflyScalar(x + k, y + k, w + k, len - k);
+}
+
+__attribute__((target("avx2")))
+static void lazyGSButterflyAVX2(uint64_t* x, uint64_t* y, const uint64_t* w, const uint64_t* wq, size_t len) {
+    const __m256i two_p = _mm256_set1_epi64x(2*(long long) P);
+    const __m256i two_p_minus_one = _mm256_set1_epi64x(2*(long long) P - 1);
+    size_t k = 0;
+    for (; k + 4 <= len; k += 4) {
+        __m256i xv = _mm256_loadu_si256((const __m256i*) (x + k));
+        __m256i yv = _mm256_loadu_si256((const __m256i*) (y + k));
+        __m256i wv = _mm256_loadu_si256((const __m256i*) (w + k));
+        __m256i wqv = _mm256_loadu_si256((const __m256i*) (wq + k));
+        __m256i s = _mm256_add_epi64(xv, yv);
+        s = _mm256_sub_epi64(s, _mm256_and_si256(_mm256_cmpgt_epi64(s, two_p_minus_one), two_p));
+        // x-y+2p < 4p < 2^44 as avx2MulShoupLazy needs
+        __m256i d = _mm256_add_epi64(_mm256_sub_epi64(xv, yv), two_p);
+        _mm256_storeu_si256((__m256i*) (x + k), s);
+        _mm256_storeu_si256((__m256i*) (y + k), avx2MulShoupLazy(wv, wqv, d));
+    }
+    lazyGSButterflyScalar(x + k, y + k, w + k, wq + k, len - k);
+}
+
+// ---------------------------------------------------------------------------
+// AVX-512 IFMA: p < 2^52 so a*b = H*2^52 + L comes straight out of
+// vpmadd52huq/vpmadd52luq, then Barrett with mu = floor(2^93 / p)
+// ---------------------------------------------------------------------------
+
+#define IFMA_TARGET __attribute__((target("avx512f,avx512ifma")))
+
+IFMA_TARGET
+static inline __m512i ifmaMulMod(__m512i a, __m512i b) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i p = _mm512_set1_epi64((long long) P);
+    const __m512i mu = _mm512_set1_epi64(3101603042345527LL);
+    const __m512i mask52 = _mm512_set1_epi64((1LL << 52) - 1);
+
+    __m512i hi = _mm512_madd52hi_epu64(zero, a, b);
+    __m512i lo = _mm512_madd52lo_epu64(zero, a, b);
+    // floor(a*b / 2^41) < 2^43
+    __m512i c1 = _mm512_or_si512(_mm512_slli_epi64(hi, 52 - (ZpFFTElement::p_bits - 1)),
+                                 _mm512_srli_epi64(lo, ZpFFTElement::p_bits - 1));
+    __m512i q = _mm512_madd52hi_epu64(zero, c1, mu);
+    // r = a*b - q*p in [0, 3p), exact mod 2^52
+    __m512i r = _mm512_and_si512(_mm512_sub_epi64(lo, _mm512_madd52lo_epu64(zero, q, p)), mask52);
+    // r - p wraps around when r < p, so the unsigned min is the corrected value
+    r = _mm512_min_epu64(r, _mm512_sub_epi64(r, p));
+    r = _mm512_min_epu64(r, _mm512_sub_epi64(r, p));
+    return r;
+}
+
+IFMA_TARGET
+static inline void ifmaButterfly(__m512i& x, __m512i& y, __m512i w) {
+    const __m512i p = _mm512_set1_epi64((long long) P);
+    __m512i t = ifmaMulMod(w, y);
+    __m512i s = _mm512_add_epi64(x, t);
+    __m512i d = _mm512_sub_epi64(x, t);
+    x = _mm512_min_epu64(s, _mm512_sub_epi64(s, p));
+    y = _mm512_min_epu64(d, _mm512_add_epi64(d, p));
+}
+
+IFMA_TARGET
+static void butterflyIFMA(uint64_t* x, uint64_t* y, const uint64_t* w, size_t len) {
+    size_t k = 0;
+    for (; k + 8 <= len; k += 8) {
+        __m512i xv = _mm512_loadu_si512((const void*) (x + k));
+        __m512i yv = _mm512_loadu_si512((const void*) (y + k));
+        __m512i wv = _mm512_loadu_si512((const void*) (w + k));
+        ifmaButterfly(xv, yv, wv);
+        _mm512_storeu_si512((void*) (x + k), xv);
+        _mm512_storeu_si512((void*) (y + k), yv);
+    }
+    butterflyScalar(x + k, y + k, w + k, len - k);
+}
+
+IFMA_TARGET
+static void pointwiseMultIFMA(uint64_t* a, const uint64_t* b, size_t len) {
+    size_t k = 0;
+    for (; k + 8 <= len; k += 8) {
+        __m512i av = _mm512_loadu_si512((const void*) (a + k));
+        __m512i bv = _mm512_loadu_si512((const void*) (b + k));
+        _mm512_storeu_si512((void*) (a + k), ifmaMulMod(av, bv));
+    }
+    pointwiseMultScalar(a + k, b + k, len - k);
+}
+
+IFMA_TARGET
+static inline void ifmaLazyButterfly(__m512i& x, __m512i& y, __m512i w, __m512i wq) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i p = _mm512_set1_epi64((long long) P);
+    const __m512i two_p = _mm512_set1_epi64(2*(long long) P);
+    const __m512i mask52 = _mm512_set1_epi64((1LL << 52) - 1);
+    __m512i u = _mm512_min_epu64(x, _mm512_sub_epi64(x, two_p));
+    // Shoup: q = wq*y >> 52, t = w*y - q*p in [0, 2p) which is exact mod 2^52
+    __m512i q = _mm512_madd52hi_epu64(zero, wq, y);
+    __m512i t = _mm512_and_si512(_mm512_sub_epi64(_mm512_madd52lo_epu64(zero, w, y),
+                                                  _mm512_madd52lo_epu64(zero, q, p)), mask52);
+    x = _mm512_add_epi64(u, t);
+    y = _mm512_add_epi64(_mm512_sub_epi64(u, t), two_p);
+}
+
+IFMA_TARGET
+static void lazyButterflyIFMA(uint64_t* x, uint64_t* y, const uint64_t* w, const uint64_t* wq, size_t len) {
+    size_t k = 0;
+    for (; k + 8 <= len; k += 8) {
+        __m512i xv = _mm512_loadu_si512((const void*) (x + k));
+        __m512i yv = _mm512_loadu_si512((const void*) (y + k));
+        __m512i wv = _mm512_loadu_si512((const void*) (w + k));
+        __m512i wqv = _mm512_loadu_si512((const void*) (wq + k));
+        ifmaLazyButterfly(xv, yv, wv, wqv);
+        _mm512_storeu_si512((void*) (x + k), xv);
+        _mm512_storeu_si512((void*) (y + k), yv);
+    }
+    lazyButterflyScalar(x + k, y + k, w + k, wq + k, len - k);
+}
+
+IFMA_TARGET
+static void broadcastButterflyIFMA(uint64_t* x, uint64_t* y, uint64_t w, size_t len) {
+    const __m512i wv = _mm512_set1_epi64((long long) w);
+    size_t k = 0;
+    for (; k + 8 <= len; k += 8) {
+        __m512i xv = _mm512_loadu_si512((const void*) (x + k));
+        __m512i yv = _mm512_loadu_si512((const void*) (y + k));
+        ifmaButterfly(xv, yv, wv);
+        _mm512_storeu_si512((void*) (x + k), xv);
+        _mm512_storeu_si512((void*) (y + k), yv);
+    }
+    broadcastButterflyScalar(x + k, y + k, w, len - k);
+}
+
+IFMA_TARGET
+static void lazyBroadcastButterflyIFMA(uint64_t* x, uint64_t* y, uint64_t w, uint64_t wq, size_t len) {
+    const __m512i wv = _mm512_set1_epi64((long long) w);
+    const __m512i wqv = _mm512_set1_epi64((long long) wq);
+    size_t k = 0;
+    for (; k + 8 <= len; k += 8) {
+        __m512i xv = _mm512_loadu_si512((const void*) (x + k));
+        __m512i yv = _mm512_loadu_si512((const void*) (y + k));
+        ifmaLazyButterfly(xv, yv, wv, wqv);
+        _mm512_storeu_si512((void*) (x + k), xv);
+        _mm512_storeu_si512((void*) (y + k), yv);
+    }
+    lazyBroadcastButterflyScalar(x + k, y + k, w, wq, len - k);
+}
+
+IFMA_TARGET
+static void radix4ButterflyIFMA(uint64_t* x0, uint64_t* x1, uint64_t* x2, uint64_t* x3,
+                                const uint64_t* w1, const uint64_t* w2, const uint64_t* w3, size_t len) {
+    size_t k = 0;
+    for (; k + 8 <= len; k += 8) {
+        __m512i a0 = _mm512_loadu_si512((const void*) (x0 + k));
+        __m512i a1 = _mm512_loadu_si512((const void*) (x1 + k));
+        __m512i a2 = _mm512_loadu_si512((const void*) (x2 + k));
+        __m512i a3 = _mm512_loadu_si512((const void*) (x3 + k));
+        __m512i v1 = _mm512_loadu_si512((const void*) (w1 + k));
+        ifmaButterfly(a0, a1, v1);
+        ifmaButterfly(a2, a3, v1);
+        ifmaButterfly(a0, a2, _mm512_loadu_si512((const void*) (w2 + k)));
+        ifmaButterfly(a1, a3, _mm512_loadu_si512((const void*) (w3 + k)));
+        _mm512_storeu_si512((void*) (x0 + k), a0);
+        _mm512_storeu_si512((void*) (x1 + k), a1);
+        _mm512_storeu_si512((void*) (x2 + k), a2);
+        _mm512_storeu_si512((void*) (x3 + k), a3);
+    }
+    radix4ButterflyScalar(x0 + k, x1 + k, x2 + k, x3 + k, w1 + k, w2 + k, w3 + k, len - k);
+}
+
+IFMA_TARGET
+static void lazyRadix4ButterflyIFMA(uint64_t* x0, uint64_t* x1, uint64_t* x2, uint64_t* x3,
+                                    const uint64_t* w1, const uint64_t* w2, const uint64_t* w3,
+                                    const uint64_t* wq1, const uint64_t* wq2, const uint64_t* wq3, size_t len) {
+    size_t k = 0;
+    for (; k + 8 <= len; k += 8) {
+        __m512i a0 = _mm512_loadu_si512((const void*) (x0 + k));
+        __m512i a1 = _mm512_loadu_si512((const void*) (x1 + k));
+        __m512i a2 = _mm512_loadu_si512((const void*) (x2 + k));
+        __m512i a3 = _mm512_loadu_si512((const void*) (x3 + k));
+        __m512i v1 = _mm512_loadu_si512((const void*) (w1 + k));
+        __m512i q1 = _mm512_loadu_si512((const void*) (wq1 + k));
+        ifmaLazyButterfly(a0, a1, v1, q1);
+        ifmaLazyButterfly(a2, a3, v1, q1);
+        ifmaLazyButterfly(a0, a2, _mm512_loadu_si512((const void*) (w2 + k)), _mm512_loadu_si512((const void*) (wq2 + k)));
+        ifmaLazyButterfly(a1, a3, _mm512_loadu_si512((const void*) (w3 + k)), _mm512_loadu_si512((const void*) (wq3 + k)));
+        _mm512_storeu_si512((void*) (x0 + k), a0);
+        _mm512_storeu_si512((void*) (x1 + k), a1);
+        _mm512_storeu_si512((void*) (x2 + k), a2);
+        _mm512_storeu_si512((void*) (x3 + k), a3);
+    }
+    lazyRadix4ButterflyScalar(x0 + k, x1 + k, x2 + k, x3 + k, w1 + k, w2 + k, w3 + k, wq1 + k, wq2 + k, wq3 + k, len - k);
+}
+
+IFMA_TARGET
+static void normalizeIFMA(uint64_t* a, size_t len) {
+    const __m512i p = _mm512_set1_epi64((long long) P);
+    const __m512i two_p = _mm512_set1_epi64(2*(long long) P);
+    size_t k = 0;
+    for (; k + 8 <= len; k += 8) {
+        __m512i av = _mm512_loadu_si512((const void*) (a + k));
+        av = _mm512_min_epu64(av, _mm512_sub_epi64(av, two_p));
+        av = _mm512_min_epu64(av, _mm512_sub_epi64(av, p));
+        _mm512_storeu_si512((void*) (a + k), av);
+    }
+    normalizeScalar(a + k, len - k);
+}
+
+IFMA_TARGET
+static void gsButterflyIFMA(uint64_t* x, uint64_t* y, const uint64_t* w, size_t len) {
+    const __m512i p = _mm512_set1_epi64((long long) P);
+    size_t k = 0;
+    for (; k + 8 <= len; k += 8) {
+        __m512i xv = _mm512_loadu_si512((const void*) (x + k));
+        __m512i yv = _mm512_loadu_si512((const void*) (y + k));
+        __m512i wv = _mm512_loadu_si512((const void*) (w + k));
+        __m512i s = _mm512_add_epi64(xv, yv);
+        s = _mm512_min_epu64(s, _mm512_sub_epi64(s, p));
+        __m512i d = _mm512_sub_epi64(xv, yv);
+        d = _mm512_min_epu64(d, _mm512_add_epi64(d, p));
+        _mm512_storeu_si512((void*) (x + k), s);
+        _mm512_storeu_si512((void*) (y + k), ifmaMulMod(wv, d));
+    }
+    gsButterflyScalar(x + k, y + k, w + k, len - k);
+}
+
+IFMA_TARGET
+static void lazyGSButterflyIFMA(uint64_t* x, uint64_t* y, const uint64_t* w, const uint64_t* wq, size_t len) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i p = _mm512_set1_epi64((long long) P);
+    const __m512i two_p = _mm512_set1_epi64(2*(long long) P);
+    const __m512i mask52 = _mm512_set1_epi64((1LL << 52) - 1);
+    size_t k = 0;
+    for (; k + 8 <= len; k += 8) {
+        __m512i xv = _mm512_loadu_si512((const void*) (x + k));
+        __m512i yv = _mm512_loadu_si512((const void*) (y + k));
+        __m512i wv = _mm512_loadu_si512((const void*) (w + k));
+        __m512i wqv = _mm512_loadu_si512((const void*) (wq + k));
+        __m512i s = _mm512_add_epi64(xv, yv);
+        s = _mm512_min_epu64(s, _mm512_sub_epi64(s, two_p));
+        __m512i d = _mm512_add_epi64(_mm512_sub_epi64(xv, yv), two_p);
+        __m512i q = _mm512_madd52hi_epu64(zero, wqv, d);
+        __m512i t = _mm512_and_si512(_mm512_sub_epi64(_mm512_madd52lo_epu64(zero, wv, d),
+                                                      _mm512_madd52lo_epu64(zero, q, p)), mask52);
+        _mm512_storeu_si512((void*) (x + k), s);
+        _mm512_storeu_si512((void*) (y + k), t);
+    }
+    lazyGSButterflyScalar(x + k, y + k, w + k, wq + k, len - k);
+}
+
+#endif
+
+static const ZpFFTKernelTable scalarKernels = {NTT_SCALAR, "scalar", butterflyScalar, pointwiseMultScalar,
+                                               lazyButterflyScalar, normalizeScalar,
+                                               gsButterflyScalar, lazyGSButterflyScalar,
+                                               radix4ButterflyScalar, lazyRadix4ButterflyScalar,
+                                               broadcastButterflyScalar, lazyBroadcastButterflyScalar};
+#ifdef __x86_64__
+static const ZpFFTKernelTable avx2Kernels = {NTT_AVX2, "avx2", butterflyAVX2, pointwiseMultAVX2,
+                                             lazyButterflyAVX2, normalizeAVX2,
+                                             gsButterflyAVX2, lazyGSButterflyAVX2,
+                                             radix4ButterflyAVX2, lazyRadix4ButterflyAVX2,
+                                             broadcastButterflyAVX2, lazyBroadcastButterflyAVX2};
+static const ZpFFTKernelTable ifmaKernels = {NTT_AVX512IFMA, "avx512ifma", butterflyIFMA, pointwiseMultIFMA,
+                                             lazyButterflyIFMA, normalizeIFMA,
+                                             gsButterflyIFMA, lazyGSButterflyIFMA,
+                                             radix4ButterflyIFMA, lazyRadix4ButterflyIFMA,
+                                             broadcastButterflyIFMA, lazyBroadcastButterflyIFMA};
+#endif
+
+bool zpFFTKernelSupported(NTTKernelISA isa) {
+    switch (isa) {
+        case NTT_SCALAR:
+            return true;
+#ifdef __x86_64__
+        case NTT_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+        case NTT_AVX512IFMA:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma");
+#endif
+        default:
+            return false;
+    }
+}
+
+const ZpFFTKernelTable& getZpFFTKernels(NTTKernelISA isa) {
+    if (!zpFFTKernelSupported(isa)) {
+        throw invalid_argument("getZpFFTKernels: this CPU does not support the requested kernels");
+    }
+    switch (isa) {
+#ifdef __x86_64__
+        case NTT_AVX2:
+            return avx2Kernels;
+        case NTT_AVX512IFMA:
+            return ifmaKernels;
+#endif
+        default:
+            return scalarKernels;
+    }
+}
+
+static const ZpFFTKernelTable* selectZpFFTKernels() {
+    if (zpFFTKernelSupported(NTT_AVX512IFMA)) {
+        return &getZpFFTKernels(NTT_AVX512IFMA);
+    }
+    if (zpFFTKernelSupported(NTT_AVX2)) {
+        return &getZpFFTKernels(NTT_AVX2);
+    }
+    return &scalarKernels;
+}
+
+const ZpFFTKernelTable& zpFFTKernels() {
+    static const ZpFFTKernelTable* best = selectZpFFTKernels();
+    return *best;
+}
@@ -0,0 +1,302 @@
+// becgabri (10/17/2026)
+
+#ifndef NTTKERNELS_H
+#define NTTKERNELS_H
+
+#include "ZpFFTElement.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// Word level kernels for the hot loops of OptimizedPSS over ZpFFTElement. All inputs
+// and outputs are canonical residues in [0, p). There is a scalar version, an AVX2
+// version (4 lanes, the 42x42 bit products are split into 32 bit halves and the
+// quotient is estimated in double precision) and an AVX-512 IFMA version (8 lanes,
+// vpmadd52luq/vpmadd52huq Barrett). The best one the CPU supports is picked once at
+// runtime through CPUID, so the binary does not need to be built with -mavx2.
+enum NTTKernelISA {
+    NTT_SCALAR = 0,
+    NTT_AVX2 = 1,
+    NTT_AVX512IFMA = 2
+};
+
+struct ZpFFTKernelTable {
+    NTTKernelISA isa;
+    const char* name;
+    // one radix-2 decimation in time layer over a block:
+    // t = w[k]*y[k], x[k] = x[k]+t, y[k] = x[k]-t for k < len
+    void (*butterfly)(uint64_t* x, uint64_t* y, const uint64_t* w, size_t len);
+    // a[k] = a[k]*b[k] for k < len
+    void (*pointwiseMult)(uint64_t* a, const uint64_t* b, size_t len);
+    // Harvey's lazy butterfly: x, y in [0, 4p) on input and output, the twiddle is
+    // multiplied with its Shoup quotient wq[k] = floor(w[k]*2^52/p) so there's no
+    // reduction beyond one conditional subtraction of 2p
+    void (*lazyButterfly)(uint64_t* x, uint64_t* y, const uint64_t* w, const uint64_t* wq, size_t len);
+    // brings a[k] in [0, 4p) back to [0, p)
+    void (*normalize)(uint64_t* a, size_t len);
+    // one radix-2 Gentleman-Sande decimation in frequency layer over a block:
+    // x[k] = x[k]+y[k], y[k] = w[k]*(x[k]-y[k]) for k < len
+    void (*gsButterfly)(uint64_t* x, uint64_t* y, const uint64_t* w, size_t len);
+    // lazy version of gsButterfly, x and y in [0, 2p) on input and output
+    void (*lazyGSButterfly)(uint64_t* x, uint64_t* y, const uint64_t* w, const uint64_t* wq, size_t len);
+    // two decimation in time layers in one pass (radix-4): butterfly(x0, x1, w1) and
+    // butterfly(x2, x3, w1), then butterfly(x0, x2, w2) and butterfly(x1, x3, w3)
+    void (*radix4Butterfly)(uint64_t* x0, uint64_t* x1, uint64_t* x2, uint64_t* x3,
+                            const uint64_t* w1, const uint64_t* w2, const uint64_t* w3, size_t len);
+    void (*lazyRadix4Butterfly)(uint64_t* x0, uint64_t* x1, uint64_t* x2, uint64_t* x3,
+                                const uint64_t* w1, const uint64_t* w2, const uint64_t* w3,
+                                const uint64_t* wq1, const uint64_t* wq2, const uint64_t* wq3, size_t len);
+    // butterfly with the same twiddle w for every k, for batches of interleaved
+    // transforms where x and y are rows of instances
+    void (*broadcastButterfly)(uint64_t* x, uint64_t* y, uint64_t w, size_t len);
+    void (*lazyBroadcastButterfly)(uint64_t* x, uint64_t* y, uint64_t w, uint64_t wq, size_t len);
+};
+
+bool zpFFTKernelSupported(NTTKernelISA isa);
+// throws if the CPU does not support isa
+const ZpFFTKernelTable& getZpFFTKernels(NTTKernelISA isa);
+// the fastest table for this CPU
+const ZpFFTKernelTable& zpFFTKernels();
+
+// Field generic front end used by OptimizedPSS, the native element forwards to the
+// dispatched word kernels. Only the native element has the lazy transform, for
+// anything else the lazy entry points just fall back on the fully reduced ones
+template <class FieldType>
+struct NTTKernels {
+    static const bool has_lazy = false;
+
+    static void lazyButterfly(FieldType* x, FieldType* y, const FieldType* w, const uint64_t* wq, int len) {
+        butterfly(x, y, w, len);
+    }
+
+    static void normalize(FieldType* a, int len) {
+    }
+
+    static uint64_t shoupQuotient(const FieldType& w) {
+        return 0;
+    }
+
+    // t = t*w for a twiddle w with Shoup quotient wq
+    static void mulTwiddle(FieldType& t, const FieldType& w, uint64_t wq) {
+        t *= w;
+    }
+
+    static void butterfly(FieldType* x, FieldType* y, const FieldType* w, int len) {
+        FieldType t;
+        for (int k = 0; k < len; k++) {
+            t = w[k] * y[k];
+            y[k] = x[k] - t;
+            x[k] += t;
+        }
+    }
+
+    static void lazyGSButterfly(FieldType* x, FieldType* y, const FieldType* w, const uint64_t* wq, int len) {
+        gsButterfly(x, y, w, len);
+    }
+
+    static void broadcastButterfly(FieldType* x, FieldType* y, const FieldType& w, int len) {
+        FieldType t;
+        for (int k = 0; k < len; k++) {
+            t = w * y[k];
+            y[k] = x[k] - t;
+            x[k] += t;
+        }
+    }
+
+    static void lazyBroadcastButterfly(FieldType* x, FieldType* y, const FieldType& w, uint64_t wq, int len) {
+        broadcastButterfly(x, y, w, len);
+    }
+
+    static void radix4Butterfly(FieldType* x0, FieldType* x1, FieldType* x2, FieldType* x3,
+                                const FieldType* w1, const FieldType* w2, const FieldType* w3, int len) {
+        butterfly(x0, x1, w1, len);
+        butterfly(x2, x3, w1, len);
+        butterfly(x0, x2, w2, len);
+        butterfly(x1, x3, w3, len);
+    }
+
+    static void lazyRadix4Butterfly(FieldType* x0, FieldType* x1, FieldType* x2, FieldType* x3,
+                                    const FieldType* w1, const FieldType* w2, const FieldType* w3,
+                                    const uint64_t* wq1, const uint64_t* wq2, const uint64_t* wq3, int len) {
+        radix4Butterfly(x0, x1, x2, x3, w1, w2, w3, len);
+    }
+
+    static void gsButterfly(FieldType* x, FieldType* y, const FieldType* w, int len) {
+        FieldType t;
+        for (int k = 0; k < len; k++) {
+            t = x[k] - y[k];
+            x[k] += y[k];
+            y[k] = w[k] * t;
+        }
+    }
+
+    // s = c*(x+y), d = c*(x-y), the last decimation in frequency layer with the
+    // scaling by c folded in. x and y may be lazy values, s and d come out reduced
+    static void scaledButterfly(const FieldType& x, const FieldType& y, FieldType& s, FieldType& d, const FieldType& c, uint64_t cq) {
+        s = (x + y) * c;
+        d = (x - y) * c;
+    }
+
+    static void pointwiseMult(FieldType* a, const FieldType* b, int len) {
+        for (int k = 0; k < len; k++) {
+            a[k] *= b[k];
+        }
+    }
+
+    // acc += w*y for a multiplier w with Shoup quotient wq. the native element leaves
+    // acc unreduced, good for 2^20 calls on a reduced acc, until reduceSum
+    static void mulAccumulate(FieldType* acc, const FieldType* y, const FieldType& w, uint64_t wq, int len) {
+        for (int k = 0; k < len; k++) {
+            acc[k] += w * y[k];
+        }
+    }
+
+    static void reduceSum(FieldType* a, int len) {
+    }
+};
+
+static_assert(sizeof(ZpFFTElement) == sizeof(uint64_t), "ZpFFTElement must be a bare word for the NTT kernels");
+
+template <>
+struct NTTKernels<ZpFFTElement> {
+    static const bool has_lazy = true;
+
+    static uint64_t* words(ZpFFTElement* a) {
+        return reinterpret_cast<uint64_t*>(a);
+    }
+
+    static const uint64_t* words(const ZpFFTElement* a) {
+        return reinterpret_cast<const uint64_t*>(a);
+    }
+
+    static void butterfly(ZpFFTElement* x, ZpFFTElement* y, const ZpFFTElement* w, int len) {
+        // the early layers have tiny blocks, an indirect call per block costs more than the math
+        if (len < 8) {
+            for (int k = 0; k < len; k++) {
+                uint64_t t = ZpFFTElement::mulMod(w[k].elem, y[k].elem);
+                uint64_t u = x[k].elem;
+                x[k].elem = ZpFFTElement::addMod(u, t);
+                y[k].elem = ZpFFTElement::subMod(u, t);
+            }
+            return;
+        }
+        zpFFTKernels().butterfly(words(x), words(y), words(w), len);
+    }
+
+    static void pointwiseMult(ZpFFTElement* a, const ZpFFTElement* b, int len) {
+        zpFFTKernels().pointwiseMult(words(a), words(b), len);
+    }
+
+    // every term is below 2p < 2^43
+    static void mulAccumulate(ZpFFTElement* acc, const ZpFFTElement* y, const ZpFFTElement& w, uint64_t wq, int len) {
+        for (int k = 0; k < len; k++) {
+            acc[k].elem += ZpFFTElement::mulShoupLazy(w.elem, wq, y[k].elem);
+        }
+    }
+
+    static void reduceSum(ZpFFTElement* a, int len) {
+        for (int k = 0; k < len; k++) {
+            a[k].elem %= ZpFFTElement::p;
+        }
+    }
+
+    static void lazyButterfly(ZpFFTElement* x, ZpFFTElement* y, const ZpFFTElement* w, const uint64_t* wq, int len) {
+        if (len < 8) {
+            const uint64_t two_p = 2*ZpFFTElement::p;
+            for (int k = 0; k < len; k++) {
+                uint64_t u = x[k].elem;
+                u -= two_p & (0 - (uint64_t) (u >= two_p));
+                uint64_t t = ZpFFTElement::mulShoupLazy(w[k].elem, wq[k], y[k].elem);
+                x[k].elem = u + t;
+                y[k].elem = u - t + two_p;
+            }
+            return;
+        }
+        zpFFTKernels().lazyButterfly(words(x), words(y), words(w), wq, len);
+    }
+
+    static void normalize(ZpFFTElement* a, int len) {
+        zpFFTKernels().normalize(words(a), len);
+    }
+
+    static void gsButterfly(ZpFFTElement* x, ZpFFTElement* y, const ZpFFTElement* w, int len) {
+        if (len < 8) {
+            for (int k = 0; k < len; k++) {
+                uint64_t u = x[k].elem;
+                uint64_t v = y[k].elem;
+                x[k].elem = ZpFFTElement::addMod(u, v);
+                y[k].elem = ZpFFTElement::mulMod(w[k].elem, ZpFFTElement::subMod(u, v));
+            }
+            return;
+        }
+        zpFFTKernels().gsButterfly(words(x), words(y), words(w), len);
+    }
+
+    static void lazyGSButterfly(ZpFFTElement* x, ZpFFTElement* y, const ZpFFTElement* w, const uint64_t* wq, int len) {
+        if (len < 8) {
+            const uint64_t two_p = 2*ZpFFTElement::p;
+            for (int k = 0; k < len; k++) {
+                uint64_t u = x[k].elem;
+                uint64_t v = y[k].elem;
+                uint64_t s = u + v;
+                x[k].elem = s - (two_p & (0 - (uint64_t) (s >= two_p)));
+                y[k].elem = ZpFFTElement::mulShoupLazy(w[k].elem, wq[k], u - v + two_p);
+            }
+            return;
+        }
+        zpFFTKernels().lazyGSButterfly(words(x), words(y), words(w), wq, len);
+    }
+
+    static void radix4Butterfly(ZpFFTElement* x0, ZpFFTElement* x1, ZpFFTElement* x2, ZpFFTElement* x3,
+                                const ZpFFTElement* w1, const ZpFFTElement* w2, const ZpFFTElement* w3, int len) {
+        if (len < 8) {
+            butterfly(x0, x1, w1, len);
+            butterfly(x2, x3, w1, len);
+            butterfly(x0, x2, w2, len);
+            butterfly(x1, x3, w3, len);
+            return;
+        }
+        zpFFTKernels().radix4Butterfly(words(x0), words(x1), words(x2), words(x3), words(w1), words(w2), words(w3), len);
+    }
+
+    static void lazyRadix4Butterfly(ZpFFTElement* x0, ZpFFTElement* x1, ZpFFTElement* x2, ZpFFTElement* x3,
+                                    const ZpFFTElement* w1, const ZpFFTElement* w2, const ZpFFTElement* w3,
+                                    const uint64_t* wq1, const uint64_t* wq2, const uint64_t* wq3, int len) {
+        if (len < 8) {
+            lazyButterfly(x0, x1, w1, wq1, len);
+            lazyButterfly(x2, x3, w1, wq1, len);
+            lazyButterfly(x0, x2, w2, wq2, len);
+            lazyButterfly(x1, x3, w3, wq3, len);
+            return;
+        }
+        zpFFTKernels().lazyRadix4Butterfly(words(x0), words(x1), words(x2), words(x3), words(w1), words(w2), words(w3),
+                                           wq1, wq2, wq3, len);
+    }
+
+    static void broadcastButterfly(ZpFFTElement* x, ZpFFTElement* y, const ZpFFTElement& w, int len) {
+        zpFFTKernels().broadcastButterfly(words(x), words(y), w.elem, len);
+    }
+
+    static void lazyBroadcastButterfly(ZpFFTElement* x, ZpFFTElement* y, const ZpFFTElement& w, uint64_t wq, int len) {
+        zpFFTKernels().lazyBroadcastButterfly(words(x), words(y), w.elem, wq, len);
+    }
+
+    // x, y in [0, 2p)
+    static void scaledButterfly(const ZpFFTElement& x, const ZpFFTElement& y, ZpFFTElement& s, ZpFFTElement& d, const ZpFFTElement& c, uint64_t cq) {
+        const uint64_t p = ZpFFTElement::p;
+        uint64_t a = ZpFFTElement::mulShoupLazy(c.elem, cq, x.elem + y.elem);
+        uint64_t b = ZpFFTElement::mulShoupLazy(c.elem, cq, x.elem - y.elem + 2*p);
+        s.elem = a - (p & (0 - (uint64_t) (a >= p)));
+        d.elem = b - (p & (0 - (uint64_t) (b >= p)));
+    }
+
+    static uint64_t shoupQuotient(const ZpFFTElement& w) {
+        return ZpFFTElement::shoupQuotient(w.elem);
+    }
+
+    static void mulTwiddle(ZpFFTElement& t, const ZpFFTElement& w, uint64_t wq) {
+        uint64_t r = ZpFFTElement::mulShoupLazy(w.elem, wq, t.elem);
+        t.elem = r - (ZpFFTElement::p & (0 - (uint64_t) (r >= ZpFFTElement::p)));
+    }
+};
+
+#endif
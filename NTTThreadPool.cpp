@@ -0,0 +1,85 @@
+// becgabri (10/17/2026)
+
+#include "NTTThreadPool.h"
+#include <stdexcept>
+
+// set on the pool threads and on a caller while it runs its own chunk
+static thread_local bool in_pool_task = false;
+
+NTTThreadPool::NTTThreadPool(int threads) : num_threads(threads), job(nullptr), job_count(0),
+                                            generation(0), pending(0), stopping(false) {
+    if (threads < 1) {
+        throw invalid_argument("NTTThreadPool: need at least one thread");
+    }
+    // the caller works too, so threads-1 helpers
+    for (int id = 1; id < threads; id++) {
+        workers.push_back(thread(&NTTThreadPool::workerLoop, this, id));
+    }
+}
+
+NTTThreadPool::~NTTThreadPool() {
+    {
+        unique_lock<mutex> guard(lock);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (auto& w : workers) {
+        w.join();
+    }
+}
+
+void NTTThreadPool::parallelFor(int count, const function<void(int, int)>& body) {
+    if (num_threads == 1 || count <= 1 || in_pool_task) {
+        body(0, count);
+        return;
+    }
+    unique_lock<mutex> call_guard(call_lock);
+    {
+        unique_lock<mutex> guard(lock);
+        job = &body;
+        job_count = count;
+        pending = num_threads - 1;
+        generation++;
+    }
+    work_ready.notify_all();
+
+    if (count / num_threads > 0) {
+        in_pool_task = true;
+        body(0, count / num_threads);
+        in_pool_task = false;
+    }
+
+    unique_lock<mutex> guard(lock);
+    work_done.wait(guard, [this] { return pending == 0; });
+    job = nullptr;
+}
+
+void NTTThreadPool::workerLoop(int id) {
+    in_pool_task = true;
+    unsigned long seen = 0;
+    while (true) {
+        const function<void(int, int)>* body;
+        int count;
+        {
+            unique_lock<mutex> guard(lock);
+            work_ready.wait(guard, [this, seen] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            body = job;
+            count = job_count;
+        }
+        int begin = (int) ((long) count * id / num_threads);
+        int end = (int) ((long) count * (id + 1) / num_threads);
+        if (begin < end) {
+            (*body)(begin, end);
+        }
+        {
+            unique_lock<mutex> guard(lock);
+            if (--pending == 0) {
+                work_done.notify_one();
+            }
+        }
+    }
+}
@@ -0,0 +1,46 @@
+// becgabri (10/17/2026)
+
+#ifndef NTTTHREADPOOL_H
+#define NTTTHREADPOOL_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+// A fixed set of worker threads for the parallel transforms. parallelFor splits
+// [0, count) into one contiguous chunk per thread, runs the first chunk on the
+// calling thread and returns once every chunk is done, so each call is a barrier.
+// A parallelFor issued from inside a chunk runs serially on that thread, which
+// lets a parallel transform call transforms that would parallelize themselves.
+// body must not throw
+class NTTThreadPool {
+public:
+    explicit NTTThreadPool(int threads);
+    ~NTTThreadPool();
+    NTTThreadPool(const NTTThreadPool&) = delete;
+    NTTThreadPool& operator=(const NTTThreadPool&) = delete;
+
+    int size() const { return num_threads; }
+    void parallelFor(int count, const function<void(int, int)>& body);
+
+private:
+    int num_threads;
+    vector<thread> workers;
+    // one parallelFor at a time, callers on other threads wait here
+    mutex call_lock;
+    mutex lock;
+    condition_variable work_ready;
+    condition_variable work_done;
+    const function<void(int, int)>* job;
+    int job_count;
+    unsigned long generation;
+    int pending;
+    bool stopping;
+    void workerLoop(int id);
+};
+
+#endif
@@ -5,14 +5,23 @@
 
 #include "./libscapi_utils/include/primitives/Mersenne.hpp"
 #include "./libscapi_utils/include/primitives/Matrix.hpp"
+#include "./libscapi_utils/include/primitives/BatchInverse.hpp"
 #include "./libscapi_utils/include/infra/Common.hpp"
 #include <iostream>
 #include <cmath>
 #include <string>
 #include <stdexcept>
 #include "TemplateField.h"
+#include "FFTFieldTraits.hpp"
+#include "NTTKernels.h"
+#include "NTTCodelets.hpp"
+#include "NTTThreadPool.h"
+#include "PolyMultiply.hpp"
 #include <tuple>
 #include <map>
+#include <algorithm>
+#include <memory>
+#include <functional>
 
 using namespace std;
 
@@ -36,46 +45,295 @@ void printRoots(vector<FieldType>& a) {
     cout << a[a.size()-1] << ")" << endl;
 }
 
+// Twiddles for one transform size 2^pow_u, built once and shared by every transform
+// of that size. Layer i of the decimation in time loop reads its 2^i twiddles
+// w_i^0 ... w_i^(2^i-1), w_i = root^(2^(pow_u-i-1)), from [2^i, 2^(i+1)). The *_q
+// vectors hold the Shoup quotients of the same entries and are only filled in for
+// fields with lazy kernels
+template <class FieldType>
+struct TwiddleTable {
+    bool built;
+    FieldType n_inv;
+    uint64_t n_inv_q;
+    vector<FieldType> forward;
+    vector<FieldType> inverse;
+    vector<uint64_t> forward_q;
+    vector<uint64_t> inverse_q;
+    TwiddleTable() : built(false), n_inv_q(0) {}
+};
+
+// Which butterflies a truncated DFT has to do to get a given set of outputs. Layer i
+// of the decimation in time loop (blocks of 2*2^i) only feeds output j through
+// offset j mod 2^i of each block, so runs[i] lists the [begin, end) offset ranges
+// that some requested output depends on, flattened into pairs
+struct TruncatedPlan {
+    int pow_u;
+    vector<vector<int> > runs;
+};
+
+// The DFT of a fixed polynomial at 2^pow_u points, made once by cacheTransform and
+// then used by every convolve with that polynomial. length is its number of
+// coefficients
+template <class FieldType>
+struct CachedTransform {
+    int pow_u;
+    int length;
+    vector<FieldType> evals;
+};
+
+// What OptimizedPSS::recoverSubsetBatch keeps for one set of parties, in increasing
+// order. parties[0 ... d] are interpolated, row r < l of rows takes their shares to
+// secret r and row l+c to the share of check party parties[d+1+c]. coeff_rows take
+// them to the low l coefficients instead, built the first time they are asked for.
+// every row is d+1 multipliers with their Shoup quotients
+template <class FieldType>
+struct SubsetRecovery {
+    vector<int> parties;
+    vector<FieldType> rows;
+    vector<uint64_t> rows_q;
+    vector<FieldType> coeff_rows;
+    vector<uint64_t> coeff_rows_q;
+};
+
+// how DFT runs its decimation in time layers: one radix-2 layer per pass over the
+// array, or two at a time (radix-4) with a radix-2 layer at the end if the number
+// of layers is odd
+enum NTTRadix {
+    NTT_RADIX2 = 2,
+    NTT_RADIX4 = 4
+};
+
+// dst = transpose of the rows x cols matrix src, in tiles so both sides stay in cache.
+// only source rows [row_begin, row_end) are moved, row_begin a multiple of the tile
+template <class FieldType>
+void transposeBlocked(const FieldType* src, FieldType* dst, int rows, int cols, int row_begin, int row_end) {
+    const int tile = 16;
+    for (int i0 = row_begin; i0 < row_end; i0 += tile) {
+        for (int j0 = 0; j0 < cols; j0 += tile) {
+            int i_end = min(i0 + tile, row_end);
+            int j_end = min(j0 + tile, cols);
+            for (int i = i0; i < i_end; i++) {
+                for (int j = j0; j < j_end; j++) {
+                    dst[(size_t) j*rows + i] = src[(size_t) i*cols + j];
+                }
+            }
+        }
+    }
+}
+
+// x with its low bits bits reversed
+inline int bitReverse(int x, int bits) {
+    int r = 0;
+    for (int i = 0; i < bits; i++) {
+        r = (r << 1) | ((x >> i) & 1);
+    }
+    return r;
+}
+
+template <class FieldType, class Traits>
+class SubproductTree;
+
+// FFT based packed secret sharing over an NTT friendly Z_p. FieldType is either
+// NTL's ZZ_p or the native ZpFFTElement (p = 3193032821761), Traits supplies the
+// roots of unity, inverses and element I/O (see FFTFieldTraits.hpp)
+template <class FieldType, class Traits = FFTFieldTraits<FieldType> >
 class OptimizedPSS {
 private:
-       vector<ZZ_p> secrets; 
+       vector<FieldType> secrets; 
 public:
         int l;
         int d;
         int n;
         int nearest_pow; 
-        ZZ_p generator; 
-        vector<ZZ_p> roots;
-        vector<ZZ_p> A_recover;
-        vector<ZZ_p> A_share;
-        vector<ZZ_p> A_pts_recover;
-        vector<ZZ_p> A_pts_share;
-        TemplateField<ZZ_p>* fieldType;
-        OptimizedPSS(int l, int d, int n, long field_size, TemplateField<ZZ_p>* field);
-        vector<ZZ_p> recoverSS(vector<ZZ_p>& samplePoints);
-        vector<ZZ_p> secretShareValues();
-        vector<ZZ_p> ptToCoeff(vector<ZZ_p>&, int, bool);
-        vector<ZZ_p> multiplyRoots(vector<int>& root_pos);
-        void setSecrets(vector<ZZ_p>& lsecrets);
+        FieldType generator; 
+        vector<FieldType> roots;
+        vector<FieldType> A_recover;
+        vector<FieldType> A_share;
+        vector<FieldType> A_pts_recover;
+        vector<FieldType> A_pts_share;
+        // A_share and A_recover on 2^k >= 2(d+1) points, what ptToCoeff multiplies by
+        CachedTransform<FieldType> A_share_evals;
+        CachedTransform<FieldType> A_recover_evals;
+        TemplateField<FieldType>* fieldType;
+        OptimizedPSS(int l, int d, int n, long field_size, TemplateField<FieldType>* field);
+        vector<FieldType> recoverSS(vector<FieldType>& samplePoints);
+        vector<FieldType> secretShareValues();
+        // secretShareValues for B packs at once, packs[b] has at most l secrets and is
+        // padded with random values the same way. returns shares[b][party], or
+        // shares[party][b] with by_party. every step is a batched DFT over rows of B
+        // values, so the twiddles are loaded once per row instead of once per pack
+        vector<vector<FieldType> > secretShareBatch(const vector<vector<FieldType> >& packs, bool by_party = false);
+        // recoverSS for B packs at once from shares[b][party] (shares[party][b] with
+        // by_party), parties 0 ... count-1 with d+1 <= count <= n for every pack. returns
+        // secrets[b], and valid[b] is false when a share past the first d+1 is off the
+        // polynomial through them. the input is left as it is
+        vector<vector<FieldType> > recoverBatch(const vector<vector<FieldType> >& shares, vector<bool>& valid, bool by_party = false);
+        // B sharings of uniformly random secrets, and of all zero secrets, laid out as
+        // secretShareBatch's. no interpolation, a random polynomial and one batched DFT.
+        // the secrets of each sharing go to secrets[b] when it is given
+        vector<vector<FieldType> > shareRandom(int batch, vector<vector<FieldType> >* secrets = nullptr, bool by_party = false);
+        vector<vector<FieldType> > shareZero(int batch, vector<vector<FieldType> >* secrets = nullptr, bool by_party = false);
+        // the coefficient embedding, the secrets are the low l coefficients of the shared
+        // polynomial instead of its values at the first l roots. sharing is one batched
+        // DFT and recovery stops at the coefficients, with a DFT only to check shares
+        // past the first d+1. a pack is a sum of s_i x^i instead of values s(x_i), which
+        // is the same for linear operations but not for products
+        vector<vector<FieldType> > shareCoeffBatch(const vector<vector<FieldType> >& packs, bool by_party = false);
+        vector<vector<FieldType> > recoverCoeffBatch(const vector<vector<FieldType> >& shares, vector<bool>& valid, bool by_party = false);
+        // between the layouts: the values at the first l roots of the polynomial with the
+        // l coefficients, and back
+        vector<FieldType> coeffsToSlots(const vector<FieldType>& coeffs);
+        vector<FieldType> slotsToCoeffs(const vector<FieldType>& slots);
+        // recoverSS from any d+1 or more parties, shares[i] = (party, its share) in any
+        // order, e.g. the first responses to arrive. the d+1 lowest parties are
+        // interpolated and the rest checked, a share off the polynomial throws like
+        // recoverSS. it is recoverSubsetBatch for one pack
+        vector<FieldType> recoverFromParties(const vector<pair<int, FieldType> >& shares, bool coeff_embedding = false);
+        // recoverBatch from the same set of at least d+1 parties for every pack,
+        // shares[b][i] (shares[i][b] with by_party) from party parties[i]. the Lagrange
+        // rows of the set are cached by its bitmask, so once a set has been seen a batch
+        // costs an (l + checks) x (d+1) matrix times the d+1 x B shares
+        vector<vector<FieldType> > recoverSubsetBatch(const vector<int>& parties, const vector<vector<FieldType> >& shares,
+                                                      vector<bool>& valid, bool by_party = false, bool coeff_embedding = false);
+        // party sets kept by recoverSubsetBatch, the cache starts over when it is full
+        int subset_cache_max;
+        vector<FieldType> ptToCoeff(vector<FieldType>&, int, bool);
+        vector<FieldType> multiplyRoots(vector<int>& root_pos);
+        void setSecrets(vector<FieldType>& lsecrets);
 	void generateRandomSecrets();
 	void generateRandomDupSecret();
-	ZZ_p& operator[](int idx);
+	FieldType& operator[](int idx);
 
-        void DFT(vector<ZZ_p>& coeffs, int pow_u);
-        void DFT(vector<ZZ_p>& coeffs, int pow_u, int beg, int end);
-        vector<ZZ_p> PreserveInDFT(vector<ZZ_p>& coeffs, int pow_u);
-        void computeN(vector<ZZ_p>& coeffs, int);
-        void InvDFT(vector<ZZ_p>& sample_pts, int pow_u, int end);
-        void polyMult(vector<ZZ_p>& a, vector<ZZ_p>& b);
-        void prepareCoeffs(vector<ZZ_p>& coeffs, int pow_u);
+        void DFT(vector<FieldType>& coeffs, int pow_u);
+        void DFT(vector<FieldType>& coeffs, int pow_u, int beg, int end);
+        // truncated DFT, only coeffs[j] for j in outputs are computed, the rest of
+        // coeffs is left with intermediate values
+        void DFT(vector<FieldType>& coeffs, int pow_u, const vector<int>& outputs);
+        void DFT(vector<FieldType>& coeffs, const TruncatedPlan& plan);
+        TruncatedPlan truncatedPlan(int pow_u, const vector<int>& outputs);
+        vector<FieldType> PreserveInDFT(vector<FieldType>& coeffs, int pow_u);
+        vector<FieldType> PreserveInDFT(vector<FieldType>& coeffs, int pow_u, int nonzero);
+        // input pruned DFT for coeffs that are zero from index nonzero on
+        void PrunedDFT(vector<FieldType>& coeffs, int pow_u, int nonzero);
+        // DFT of batch instances stored interleaved, data[i*batch + b] is coefficient
+        // (and on return evaluation) i of instance b
+        void DFTBatch(vector<FieldType>& data, int pow_u, int batch);
+        void computeN(vector<FieldType>& coeffs, int);
+        void InvDFT(vector<FieldType>& sample_pts, int pow_u, int end);
+        void polyMult(vector<FieldType>& a, vector<FieldType>& b);
+        // out = a*b, schoolbook if the shorter operand has at most schoolbook_max
+        // coefficients, Karatsuba if the longer one has at most karatsuba_max (or the
+        // product has more coefficients than there are roots of unity), convolve
+        // otherwise. out may alias a or b
+        void polyMult(const vector<FieldType>& a, const vector<FieldType>& b, vector<FieldType>& out);
+        // the same on raw coefficients, out has room for la+lb-1 entries
+        void polyMult(const FieldType* a, int la, const FieldType* b, int lb, FieldType* out);
+        // product of two monic polynomials, the transform only has to cover the degree
+        // since the one coefficient that wraps around is known to be 1. halves the
+        // transform for the 2^j * 2^j products of a subproduct tree
+        void monicPolyMult(const FieldType* a, int la, const FieldType* b, int lb, FieldType* out);
+        // out = a*b through the smallest transform that holds the product: forward(a)
+        // and forward(b) into workspace, pointwise product, inverse into out. workspace
+        // grows to 2^(pow_u+1) entries on first use and is reused after, out may alias
+        // a or b
+        void convolve(const vector<FieldType>& a, const vector<FieldType>& b,
+                      vector<FieldType>& out, vector<FieldType>& workspace);
+        // same with the transform of b cached, a.size() + b.length - 1 must fit in
+        // 2^b.pow_u points. out_len >= 0 keeps only the first out_len coefficients
+        void convolve(const vector<FieldType>& a, const CachedTransform<FieldType>& b,
+                      vector<FieldType>& out, vector<FieldType>& workspace, int out_len = -1);
+        CachedTransform<FieldType> cacheTransform(const vector<FieldType>& b, int pow_u);
+        void prepareCoeffs(vector<FieldType>& coeffs, int pow_u);
+        // use Harvey's lazy reduction butterflies when the field has them (ZpFFTElement)
+        bool lazy_reduction;
+        NTTRadix radix;
+        // full DFTs of 2^3 ... 2^6 points go through the unrolled codelets
+        bool codelets;
+        // DFTs of at least 2^four_step_log points run as four step transforms, never
+        // below 2^2 points since a 2 point four step transform would be one again
+        int four_step_log;
+        // full DFTs of at least 2^parallel_log points split their layers (or the four
+        // step sub-transforms) over thread_pool. no pool, or a pool of one thread,
+        // keeps everything on the calling thread. the pool can be shared between
+        // instances
+        shared_ptr<NTTThreadPool> thread_pool;
+        int parallel_log;
+        int schoolbook_max;
+        int karatsuba_max;
 
 private:
+        // tables[pow_u] for every transform size up to nearest_pow, nearest_pow and
+        // nearest_pow-1 are built by the constructor and the rest on first use
+        vector<TwiddleTable<FieldType> > tables;
+        TwiddleTable<FieldType>& twiddleTable(int pow_u);
+        // the roots are the compile time ones in ZpFFTRootTables.hpp
+        bool fixed_roots;
+        // generator^e, looked up in the nearest_pow twiddle table
+        FieldType rootPower(int e);
+        // the outputs secretShareValues hands out, and the ones recoverSS checks
+        // keyed by the number of check points
+        TruncatedPlan share_plan;
+        map<int, TruncatedPlan> recover_plans;
+        // InvDFT's last layer writes here and swaps it with its argument
+        vector<FieldType> inv_scratch;
+        // polyMult's convolve workspace, and its buffers for the transform free products
+        vector<FieldType> conv_workspace;
+        vector<FieldType> mult_out;
+        vector<FieldType> mult_scratch;
+        // the batch APIs' interleaved buffers, the Shoup quotients of A_pts_share and
+        // A_pts_recover, and batchToCoeff's scales with quotients, built on first use
+        vector<FieldType> batch_points;
+        vector<FieldType> batch_conv;
+        vector<uint64_t> share_pts_q;
+        vector<uint64_t> recover_pts_q;
+        vector<FieldType> share_batch_scale;
+        vector<uint64_t> share_batch_scale_q;
+        vector<FieldType> recover_batch_scale;
+        vector<uint64_t> recover_batch_scale_q;
+        void batchToCoeff(int pow_u, int batch, const CachedTransform<FieldType>& a_evals,
+                          vector<FieldType>& scale, vector<uint64_t>& scale_q);
+        // prod (x - x_i) over the secret points on all the roots, for shareZero
+        CachedTransform<FieldType> vanishing_evals;
+        vector<uint64_t> vanishing_evals_q;
+        map<vector<uint64_t>, SubsetRecovery<FieldType> > subset_cache;
+        SubsetRecovery<FieldType>& subsetRecovery(const vector<int>& sorted_parties, bool coeff_embedding);
+        // the tree over the secret points for slotsToCoeffs, built on first use
+        shared_ptr<SubproductTree<FieldType, Traits> > slot_tree;
+        vector<vector<FieldType> > batchRecover(const vector<vector<FieldType> >& shares, vector<bool>& valid,
+                                                bool by_party, bool coeff_embedding);
+        // row of the nearest_pow DFT that holds party's share
+        int shareRow(int party) const;
+        // every party's share from batch_points after the nearest_pow batch DFT
+        vector<vector<FieldType> > batchShares(int batch, bool by_party);
+        int convolutionLog(int num_pts);
+        void multiplyInto(const FieldType* a, int la, const FieldType* b, int lb, vector<FieldType>& result);
+        // a*b mod x^(2^pow_u) - 1 through workspace, returns where in workspace its
+        // first num_pts coefficients are
+        FieldType* convolveInto(const FieldType* a, int la, const FieldType* b, int lb,
+                                int pow_u, int num_pts, vector<FieldType>& workspace);
+        // DFT of src[0 ... src_len) zero padded to 2^pow_u points, into dst
+        void forwardInto(const FieldType* src, int src_len, FieldType* dst, int pow_u);
+        // inverse DFT of in (destroyed), coefficients 0 ... end-1 into out, which needs
+        // room for 2^pow_u entries
+        void inverseInto(FieldType* in, int pow_u, FieldType* out, int end);
+        void transform(FieldType* coeffs, int pow_u, const TruncatedPlan* plan = nullptr, int nonzero = -1);
+        void fourStep(FieldType* coeffs, int pow_u);
+        void dftBatch(FieldType* rows, int pow_u, int batch, size_t stride);
+        void dftLayers(FieldType* out, int pow_u, const TruncatedPlan* plan = nullptr, int nonzero = -1);
+        void dftLayersParallel(FieldType* out, int pow_u);
+        bool parallelSize(int pow_u);
+        bool fourStepSize(int pow_u) const { return pow_u >= max(four_step_log, 2); }
+        // body(begin, end) over [0, count), split over thread_pool when a transform
+        // of 2^pow_u points runs in parallel
+        void runParallel(int pow_u, int count, const function<void(int, int)>& body);
+        void dftBlock(FieldType* out, int pow_u, int i, int base, const TruncatedPlan* plan, int nonzero, bool lazy);
+        void dftBlock4(FieldType* out, int pow_u, int i, int base, const TruncatedPlan* plan, int nonzero, bool lazy);
         void reverse_add(int& itr,int pow);
-        vector<ZZ_p> multPolyList(vector<vector<ZZ_p>>& polys);
     
 };
 
-ZZ_p& OptimizedPSS::operator[](int idx){
+template <class FieldType, class Traits>
+FieldType& OptimizedPSS<FieldType, Traits>::operator[](int idx){
 	if (idx >= l) {
 		throw invalid_argument("Trying to access a secret value outsid of pack range");
 	}
@@ -85,44 +343,48 @@ ZZ_p& OptimizedPSS::operator[](int idx){
 	return secrets[idx];
 }
 
-void OptimizedPSS::generateRandomSecrets() {
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::generateRandomSecrets() {
     for (int i = 0; i < l; i++) {
         secrets.push_back(fieldType->Random());
     }
 }
 
-void OptimizedPSS::generateRandomDupSecret() {
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::generateRandomDupSecret() {
     auto same_secret = fieldType->Random();
     for (int i = 0; i < l; i++) {
         secrets.push_back(same_secret);
     }
 }
 
-void OptimizedPSS::setSecrets(vector<ZZ_p>& lsecrets){
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::setSecrets(vector<FieldType>& lsecrets){
     if (lsecrets.size() > l) {
         throw std::invalid_argument("Can't pack more secrets than l!");
     }
-    secrets = vector<ZZ_p>(lsecrets.begin(), lsecrets.end());
+    secrets = vector<FieldType>(lsecrets.begin(), lsecrets.end());
 }
 
-vector<ZZ_p> OptimizedPSS::secretShareValues() {
+template <class FieldType, class Traits>
+vector<FieldType> OptimizedPSS<FieldType, Traits>::secretShareValues() {
     // pad out points for coefficient reconstr. 
     int num_rest_pts = d+1-secrets.size();
     // sample $ y values
-    vector<ZZ_p> defin_pts(secrets.begin(), secrets.end());
+    vector<FieldType> defin_pts(secrets.begin(), secrets.end());
     for (int i = 0; i < num_rest_pts; i++) {
         auto rand = fieldType->Random();
         defin_pts.push_back(rand);
     }
-    vector<ZZ_p> defin_pts2(defin_pts.begin(), defin_pts.end());
+    vector<FieldType> defin_pts2(defin_pts.begin(), defin_pts.end());
     bool isShare = true;
-    vector<ZZ_p> shares(defin_pts.begin()+l, defin_pts.end());
+    vector<FieldType> shares(defin_pts.begin()+l, defin_pts.end());
     shares.reserve(n);
 
-    vector<ZZ_p> recov_coeff;
+    vector<FieldType> recov_coeff;
     recov_coeff = ptToCoeff(defin_pts, nearest_pow-1,isShare);
     prepareCoeffs(recov_coeff, nearest_pow);
-    DFT(recov_coeff, nearest_pow);
+    transform(&recov_coeff[0], nearest_pow, &share_plan, d+1);
     // need to pick out the right points here :( 
     int rest_of_pts = n-(d+1-l);
     int end = rest_of_pts + d+1 < (1 << nearest_pow-1) ? rest_of_pts : (1 << nearest_pow-1) - (d+1);
@@ -135,8 +397,482 @@ vector<ZZ_p> OptimizedPSS::secretShareValues() {
     return shares;
 }
 
-vector<ZZ_p> OptimizedPSS::ptToCoeff(vector<ZZ_p>& samplePoints,int pow_u, bool is_share) {
-    vector<ZZ_p> n_i;
+// secretShareValues with every pack in a column of batch_points, see batchToCoeff
+template <class FieldType, class Traits>
+vector<vector<FieldType> > OptimizedPSS<FieldType, Traits>::secretShareBatch(const vector<vector<FieldType> >& packs, bool by_party) {
+    int batch = packs.size();
+    for (int b = 0; b < batch; b++) {
+        if (packs[b].size() > l) {
+            throw std::invalid_argument("Can't pack more secrets than l!");
+        }
+    }
+    if (batch == 0) {
+        return vector<vector<FieldType> >();
+    }
+    if (share_pts_q.empty()) {
+        share_pts_q.resize(d+1);
+        for (int i = 0; i < d+1; i++) {
+            share_pts_q[i] = NTTKernels<FieldType>::shoupQuotient(A_pts_share[i]);
+        }
+    }
+    // row i holds point i of every pack, the secrets and then the random values that
+    // are the first d+1-l shares (and come back out of the last DFT)
+    int pow_u = nearest_pow-1;
+    batch_points.assign((size_t) (1 << pow_u) * batch, fieldType->GetElement(0));
+    fieldType->Random(&batch_points[(size_t) l*batch], (d+1-l)*batch);
+    for (int b = 0; b < batch; b++) {
+        for (int i = 0; i < l; i++) {
+            batch_points[(size_t) i*batch + b] = i < packs[b].size() ? packs[b][i] : fieldType->Random();
+        }
+    }
+    for (int i = 0; i < d+1; i++) {
+        FieldType* row = &batch_points[(size_t) i*batch];
+        for (int b = 0; b < batch; b++) {
+            NTTKernels<FieldType>::mulTwiddle(row[b], A_pts_share[i], share_pts_q[i]);
+        }
+    }
+    batchToCoeff(pow_u, batch, A_share_evals, share_batch_scale, share_batch_scale_q);
+    dftBatch(&batch_points[0], nearest_pow, batch, batch);
+    return batchShares(batch, by_party);
+}
+
+// recoverSS with every pack in a column of batch_points. nothing is thrown for a bad
+// share, its pack is flagged in valid and the others are checked on
+template <class FieldType, class Traits>
+vector<vector<FieldType> > OptimizedPSS<FieldType, Traits>::recoverBatch(const vector<vector<FieldType> >& shares,
+                                                                        vector<bool>& valid, bool by_party) {
+    return batchRecover(shares, valid, by_party, false);
+}
+
+template <class FieldType, class Traits>
+vector<vector<FieldType> > OptimizedPSS<FieldType, Traits>::recoverCoeffBatch(const vector<vector<FieldType> >& shares,
+                                                                             vector<bool>& valid, bool by_party) {
+    return batchRecover(shares, valid, by_party, true);
+}
+
+// the secrets are the first l coefficients out of batchToCoeff, or its polynomials at
+// the secret points. the DFT that gives those also gives the check points, in the
+// coefficient embedding it only runs when there is something to check
+template <class FieldType, class Traits>
+vector<vector<FieldType> > OptimizedPSS<FieldType, Traits>::batchRecover(const vector<vector<FieldType> >& shares,
+                                                                        vector<bool>& valid, bool by_party, bool coeff_embedding) {
+    int batch = by_party ? (shares.empty() ? 0 : shares[0].size()) : shares.size();
+    int count = by_party ? shares.size() : (shares.empty() ? 0 : shares[0].size());
+    vector<vector<FieldType> > secrets;
+    valid.assign(batch, true);
+    if (batch == 0) {
+        return secrets;
+    }
+    if (count < d+1) {
+        throw std::invalid_argument("Not enough points to recover the secrets!");
+    }
+    if (count > n) {
+        throw std::invalid_argument("More shares than parties!");
+    }
+    for (int r = 0; r < shares.size(); r++) {
+        if (shares[r].size() != (by_party ? batch : count)) {
+            throw std::invalid_argument("recoverBatch:: every pack needs the same number of shares");
+        }
+    }
+    if (recover_pts_q.empty()) {
+        recover_pts_q.resize(d+1);
+        for (int i = 0; i < d+1; i++) {
+            recover_pts_q[i] = NTTKernels<FieldType>::shoupQuotient(A_pts_recover[i]);
+        }
+    }
+    auto share = [&](int party, int b) -> const FieldType& {
+        return by_party ? shares[party][b] : shares[b][party];
+    };
+
+    batch_points.assign((size_t) (1 << nearest_pow) * batch, fieldType->GetElement(0));
+    for (int i = 0; i < d+1; i++) {
+        FieldType* row = &batch_points[(size_t) shareRow(i)*batch];
+        for (int b = 0; b < batch; b++) {
+            row[b] = share(i, b);
+            NTTKernels<FieldType>::mulTwiddle(row[b], A_pts_recover[i], recover_pts_q[i]);
+        }
+    }
+    batchToCoeff(nearest_pow, batch, A_recover_evals, recover_batch_scale, recover_batch_scale_q);
+    secrets.assign(batch, vector<FieldType>(l));
+    auto take_secrets = [&](int stride) {
+        for (int i = 0; i < l; i++) {
+            const FieldType* row = &batch_points[(size_t) stride*i*batch];
+            for (int b = 0; b < batch; b++) {
+                secrets[b][i] = row[b];
+            }
+        }
+    };
+    if (coeff_embedding) {
+        take_secrets(1);
+        if (count == d+1) {
+            return secrets;
+        }
+    }
+    dftBatch(&batch_points[0], nearest_pow, batch, batch);
+    // every received share past the first d+1 against the polynomial, a row at a time
+    for (int j = d+1; j < count; j++) {
+        const FieldType* row = &batch_points[(size_t) shareRow(j)*batch];
+        for (int b = 0; b < batch; b++) {
+            if (row[b] != share(j, b)) {
+                valid[b] = false;
+            }
+        }
+    }
+    if (!coeff_embedding) {
+        take_secrets(2);
+    }
+    return secrets;
+}
+
+// the coefficient embedding: f = s_0 + s_1 x + ... + s_{l-1} x^(l-1) plus d+1-l random
+// coefficients, so any d+1-l shares are uniform as with the secrets at points, and
+// sharing is the one DFT
+template <class FieldType, class Traits>
+vector<vector<FieldType> > OptimizedPSS<FieldType, Traits>::shareCoeffBatch(const vector<vector<FieldType> >& packs, bool by_party) {
+    int batch = packs.size();
+    for (int b = 0; b < batch; b++) {
+        if (packs[b].size() > l) {
+            throw std::invalid_argument("Can't pack more secrets than l!");
+        }
+    }
+    if (batch == 0) {
+        return vector<vector<FieldType> >();
+    }
+    batch_points.assign((size_t) (1 << nearest_pow) * batch, fieldType->GetElement(0));
+    fieldType->Random(&batch_points[(size_t) l*batch], (d+1-l)*batch);
+    for (int b = 0; b < batch; b++) {
+        for (int i = 0; i < l; i++) {
+            batch_points[(size_t) i*batch + b] = i < packs[b].size() ? packs[b][i] : fieldType->Random();
+        }
+    }
+    dftBatch(&batch_points[0], nearest_pow, batch, batch);
+    return batchShares(batch, by_party);
+}
+
+// s(x_i) for the polynomial s with coefficients s_0 ... s_{l-1}, x_i = h^i, which is
+// the first l outputs of its DFT on the half size group
+template <class FieldType, class Traits>
+vector<FieldType> OptimizedPSS<FieldType, Traits>::coeffsToSlots(const vector<FieldType>& coeffs) {
+    if (coeffs.size() != l) {
+        throw std::invalid_argument("coeffsToSlots:: need l coefficients");
+    }
+    vector<FieldType> slots(coeffs);
+    prepareCoeffs(slots, nearest_pow-1);
+    transform(&slots[0], nearest_pow-1, nullptr, l);
+    slots.resize(l);
+    return slots;
+}
+
+// the polynomial of degree < l through (x_i, slots[i]), over a subproduct tree of the
+// secret points kept for the next call
+template <class FieldType, class Traits>
+vector<FieldType> OptimizedPSS<FieldType, Traits>::slotsToCoeffs(const vector<FieldType>& slots) {
+    if (slots.size() != l) {
+        throw std::invalid_argument("slotsToCoeffs:: need l slots");
+    }
+    if (!slot_tree) {
+        slot_tree = make_shared<SubproductTree<FieldType, Traits> >(this, vector<FieldType>(roots.begin(), roots.begin() + l));
+    }
+    return slot_tree->interpolate(slots);
+}
+
+template <class FieldType, class Traits>
+vector<FieldType> OptimizedPSS<FieldType, Traits>::recoverFromParties(const vector<pair<int, FieldType> >& shares, bool coeff_embedding) {
+    vector<int> parties(shares.size());
+    vector<vector<FieldType> > pack(1, vector<FieldType>(shares.size()));
+    for (int i = 0; i < shares.size(); i++) {
+        parties[i] = shares[i].first;
+        pack[0][i] = shares[i].second;
+    }
+    vector<bool> valid;
+    auto secrets = recoverSubsetBatch(parties, pack, valid, false, coeff_embedding);
+    if (!valid[0]) {
+        throw std::invalid_argument("Recovered point is incorrect");
+    }
+    return secrets[0];
+}
+
+template <class FieldType, class Traits>
+vector<vector<FieldType> > OptimizedPSS<FieldType, Traits>::recoverSubsetBatch(const vector<int>& parties, const vector<vector<FieldType> >& shares,
+                                                                              vector<bool>& valid, bool by_party, bool coeff_embedding) {
+    int count = parties.size();
+    int batch = by_party ? (shares.empty() ? 0 : shares[0].size()) : shares.size();
+    if (count < d+1) {
+        throw std::invalid_argument("Not enough points to recover the secrets!");
+    }
+    if (by_party && shares.size() != count) {
+        throw std::invalid_argument("recoverSubsetBatch:: need the shares of every party");
+    }
+    for (int r = 0; r < shares.size(); r++) {
+        if (shares[r].size() != (by_party ? batch : count)) {
+            throw std::invalid_argument("recoverSubsetBatch:: every pack needs the same number of shares");
+        }
+    }
+    // where each party of the set, in increasing order, is in the input
+    vector<int> order(count);
+    for (int i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    sort(order.begin(), order.end(), [&](int a, int b) { return parties[a] < parties[b]; });
+    vector<int> sorted_parties(count);
+    for (int i = 0; i < count; i++) {
+        sorted_parties[i] = parties[order[i]];
+        if (sorted_parties[i] < 0 || sorted_parties[i] >= n) {
+            throw std::invalid_argument("recoverSubsetBatch:: party out of range");
+        }
+        if (i > 0 && sorted_parties[i] == sorted_parties[i-1]) {
+            throw std::invalid_argument("recoverSubsetBatch:: party appears twice");
+        }
+    }
+    vector<vector<FieldType> > secrets;
+    valid.assign(batch, true);
+    if (batch == 0) {
+        return secrets;
+    }
+    SubsetRecovery<FieldType>& rec = subsetRecovery(sorted_parties, coeff_embedding);
+    auto share = [&](int i, int b) -> const FieldType& {
+        return by_party ? shares[order[i]][b] : shares[b][order[i]];
+    };
+
+    auto zero = fieldType->GetElement(0);
+    batch_points.resize((size_t) (d+1) * batch);
+    for (int k = 0; k < d+1; k++) {
+        for (int b = 0; b < batch; b++) {
+            batch_points[(size_t) k*batch + b] = share(k, b);
+        }
+    }
+    batch_conv.resize(batch);
+    // batch_conv = row times the shares, one row of batch values at a time
+    auto combine = [&](const FieldType* row, const uint64_t* row_q) {
+        fill(batch_conv.begin(), batch_conv.end(), zero);
+        for (int k = 0; k < d+1; k++) {
+            NTTKernels<FieldType>::mulAccumulate(&batch_conv[0], &batch_points[(size_t) k*batch], row[k], row_q[k], batch);
+        }
+        NTTKernels<FieldType>::reduceSum(&batch_conv[0], batch);
+    };
+    for (int c = 0; c < count-(d+1); c++) {
+        combine(&rec.rows[(size_t) (l+c)*(d+1)], &rec.rows_q[(size_t) (l+c)*(d+1)]);
+        for (int b = 0; b < batch; b++) {
+            if (batch_conv[b] != share(d+1+c, b)) {
+                valid[b] = false;
+            }
+        }
+    }
+    const vector<FieldType>& out_rows = coeff_embedding ? rec.coeff_rows : rec.rows;
+    const vector<uint64_t>& out_rows_q = coeff_embedding ? rec.coeff_rows_q : rec.rows_q;
+    secrets.assign(batch, vector<FieldType>(l));
+    for (int i = 0; i < l; i++) {
+        combine(&out_rows[(size_t) i*(d+1)], &out_rows_q[(size_t) i*(d+1)]);
+        for (int b = 0; b < batch; b++) {
+            secrets[b][i] = batch_conv[b];
+        }
+    }
+    return secrets;
+}
+
+// with A = prod (x - x_k) over the interpolated points and w_k their barycentric weights,
+// the Lagrange basis is l_k(t) = w_k A(t) / (t - x_k) at any other point t. the low
+// coefficients of A / (x - x_k) come from the series -A(x)/x_k sum (x/x_k)^j, or
+// q_0 = -a_0/x_k and q_j = (q_{j-1} - a_j)/x_k
+template <class FieldType, class Traits>
+SubsetRecovery<FieldType>& OptimizedPSS<FieldType, Traits>::subsetRecovery(const vector<int>& sorted_parties, bool coeff_embedding) {
+    vector<uint64_t> key((n + 63) / 64, 0);
+    for (int i = 0; i < sorted_parties.size(); i++) {
+        key[sorted_parties[i] / 64] |= (uint64_t) 1 << (sorted_parties[i] % 64);
+    }
+    auto found = subset_cache.find(key);
+    if (found == subset_cache.end()) {
+        if (subset_cache.size() >= max(subset_cache_max, 1)) {
+            subset_cache.clear();
+        }
+        found = subset_cache.insert(make_pair(key, SubsetRecovery<FieldType>())).first;
+    }
+    SubsetRecovery<FieldType>& rec = found->second;
+    bool build_rows = rec.parties.empty();
+    bool build_coeffs = coeff_embedding && rec.coeff_rows.empty();
+    if (!build_rows && !build_coeffs) {
+        return rec;
+    }
+    rec.parties = sorted_parties;
+    vector<FieldType> pts(d+1);
+    for (int k = 0; k < d+1; k++) {
+        pts[k] = rootPower(shareRow(sorted_parties[k]));
+    }
+    SubproductTree<FieldType, Traits> tree(this, pts);
+    const vector<FieldType>& weights = tree.barycentricWeights();
+    if (build_rows) {
+        int targets = l + sorted_parties.size() - (d+1);
+        vector<FieldType> inv_diffs((size_t) targets * (d+1));
+        vector<FieldType> a_at(targets, fieldType->GetElement(1));
+        for (int r = 0; r < targets; r++) {
+            auto t = r < l ? rootPower(2*r) : rootPower(shareRow(sorted_parties[d+1+r-l]));
+            for (int k = 0; k < d+1; k++) {
+                inv_diffs[(size_t) r*(d+1) + k] = t - pts[k];
+                a_at[r] *= inv_diffs[(size_t) r*(d+1) + k];
+            }
+        }
+        batchInverse(&inv_diffs[0], inv_diffs.size(), fieldType->GetElement(1));
+        rec.rows.resize(inv_diffs.size());
+        rec.rows_q.resize(inv_diffs.size());
+        for (int r = 0; r < targets; r++) {
+            for (int k = 0; k < d+1; k++) {
+                auto idx = (size_t) r*(d+1) + k;
+                rec.rows[idx] = weights[k] * a_at[r] * inv_diffs[idx];
+                rec.rows_q[idx] = NTTKernels<FieldType>::shoupQuotient(rec.rows[idx]);
+            }
+        }
+    }
+    if (build_coeffs) {
+        vector<FieldType> a = tree.root();
+        rec.coeff_rows.resize((size_t) l*(d+1));
+        rec.coeff_rows_q.resize((size_t) l*(d+1));
+        for (int k = 0; k < d+1; k++) {
+            auto x_inv = rootPower(-shareRow(sorted_parties[k]));
+            auto q = fieldType->GetElement(0);
+            for (int j = 0; j < l; j++) {
+                q = (q - a[j]) * x_inv;
+                auto idx = (size_t) j*(d+1) + k;
+                rec.coeff_rows[idx] = weights[k] * q;
+                rec.coeff_rows_q[idx] = NTTKernels<FieldType>::shoupQuotient(rec.coeff_rows[idx]);
+            }
+        }
+    }
+    return rec;
+}
+
+// a uniformly random polynomial of degree d evaluated on all the roots: the secrets
+// are uniform and the shares are those of secretShareValues on them, without the
+// interpolation
+template <class FieldType, class Traits>
+vector<vector<FieldType> > OptimizedPSS<FieldType, Traits>::shareRandom(int batch, vector<vector<FieldType> >* secrets, bool by_party) {
+    if (batch <= 0) {
+        throw std::invalid_argument("shareRandom:: batch must be positive");
+    }
+    batch_points.assign((size_t) (1 << nearest_pow) * batch, fieldType->GetElement(0));
+    fieldType->Random(&batch_points[0], (d+1)*batch);
+    dftBatch(&batch_points[0], nearest_pow, batch, batch);
+    if (secrets != nullptr) {
+        secrets->assign(batch, vector<FieldType>(l));
+        for (int i = 0; i < l; i++) {
+            const FieldType* row = &batch_points[(size_t) 2*i*batch];
+            for (int b = 0; b < batch; b++) {
+                (*secrets)[b][i] = row[b];
+            }
+        }
+    }
+    return batchShares(batch, by_party);
+}
+
+// r * V for r uniformly random of degree d-l and V = prod (x - x_i) over the secret
+// points is uniform over the degree d polynomials that are zero on them. it is
+// evaluated as DFT(r) times the cached DFT(V), d < 2^nearest_pow so nothing wraps
+template <class FieldType, class Traits>
+vector<vector<FieldType> > OptimizedPSS<FieldType, Traits>::shareZero(int batch, vector<vector<FieldType> >* secrets, bool by_party) {
+    if (batch <= 0) {
+        throw std::invalid_argument("shareZero:: batch must be positive");
+    }
+    auto order_gr = (1 << nearest_pow);
+    if (vanishing_evals.evals.empty()) {
+        vector<int> secret_roots(l);
+        for (int i = 0; i < l; i++) {
+            secret_roots[i] = i;
+        }
+        vanishing_evals = cacheTransform(multiplyRoots(secret_roots), nearest_pow);
+        vanishing_evals_q.resize(order_gr);
+        for (int k = 0; k < order_gr; k++) {
+            vanishing_evals_q[k] = NTTKernels<FieldType>::shoupQuotient(vanishing_evals.evals[k]);
+        }
+    }
+    batch_points.assign((size_t) order_gr * batch, fieldType->GetElement(0));
+    fieldType->Random(&batch_points[0], (d+1-l)*batch);
+    dftBatch(&batch_points[0], nearest_pow, batch, batch);
+    for (int j = 0; j < n; j++) {
+        int k = shareRow(j);
+        FieldType* row = &batch_points[(size_t) k*batch];
+        for (int b = 0; b < batch; b++) {
+            NTTKernels<FieldType>::mulTwiddle(row[b], vanishing_evals.evals[k], vanishing_evals_q[k]);
+        }
+    }
+    if (secrets != nullptr) {
+        secrets->assign(batch, vector<FieldType>(l, fieldType->GetElement(0)));
+    }
+    return batchShares(batch, by_party);
+}
+
+// party j's point is root 2(l+j), h^(l+j), while that is in the half size group and an
+// odd root after it, the order secretShareValues and recoverSS use
+template <class FieldType, class Traits>
+int OptimizedPSS<FieldType, Traits>::shareRow(int party) const {
+    int half = (1 << nearest_pow-1);
+    return l+party < half ? 2*(l+party) : 2*(l+party-half)+1;
+}
+
+template <class FieldType, class Traits>
+vector<vector<FieldType> > OptimizedPSS<FieldType, Traits>::batchShares(int batch, bool by_party) {
+    vector<vector<FieldType> > shares;
+    if (by_party) {
+        shares.resize(n);
+        for (int j = 0; j < n; j++) {
+            const FieldType* row = &batch_points[(size_t) shareRow(j)*batch];
+            shares[j].assign(row, row + batch);
+        }
+    } else {
+        shares.assign(batch, vector<FieldType>(n));
+        for (int j = 0; j < n; j++) {
+            const FieldType* row = &batch_points[(size_t) shareRow(j)*batch];
+            for (int b = 0; b < batch; b++) {
+                shares[b][j] = row[b];
+            }
+        }
+    }
+    return shares;
+}
+
+// ptToCoeff for batch columns: batch_points holds n_i = y_i / A'(x_i) for every pack in
+// (1 << pow_u) rows and gets the first d+1 coefficients of each interpolated polynomial,
+// zero padded to (1 << nearest_pow) rows. the DFT of the n_i is read backwards and
+// negated as in computeN, and the product with A through a_evals is inverted with a
+// forward DFT read at -k, the negation and 1/2^cached_pow going into scale
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::batchToCoeff(int pow_u, int batch, const CachedTransform<FieldType>& a_evals,
+                                                   vector<FieldType>& scale, vector<uint64_t>& scale_q) {
+    auto zero = fieldType->GetElement(0);
+    int cached_pow = a_evals.pow_u;
+    auto mask = (1 << pow_u) - 1;
+    auto cached_mask = (1 << cached_pow) - 1;
+    if (scale.empty()) {
+        auto neg_inv = -twiddleTable(cached_pow).n_inv;
+        scale.resize(1 << cached_pow);
+        scale_q.resize(1 << cached_pow);
+        for (int k = 0; k < (1 << cached_pow); k++) {
+            scale[k] = a_evals.evals[k] * neg_inv;
+            scale_q[k] = NTTKernels<FieldType>::shoupQuotient(scale[k]);
+        }
+    }
+    dftBatch(&batch_points[0], pow_u, batch, batch);
+    batch_conv.assign((size_t) (1 << cached_pow) * batch, zero);
+    for (int it = 0; it < d+1; it++) {
+        const FieldType* src = &batch_points[(size_t) ((mask - it) & mask) * batch];
+        copy(src, src + batch, &batch_conv[(size_t) it*batch]);
+    }
+    dftBatch(&batch_conv[0], cached_pow, batch, batch);
+    for (int k = 0; k < (1 << cached_pow); k++) {
+        FieldType* row = &batch_conv[(size_t) k*batch];
+        for (int b = 0; b < batch; b++) {
+            NTTKernels<FieldType>::mulTwiddle(row[b], scale[k], scale_q[k]);
+        }
+    }
+    dftBatch(&batch_conv[0], cached_pow, batch, batch);
+    batch_points.assign((size_t) (1 << nearest_pow) * batch, zero);
+    for (int k = 0; k < d+1; k++) {
+        const FieldType* src = &batch_conv[(size_t) (-k & cached_mask) * batch];
+        copy(src, src + batch, &batch_points[(size_t) k*batch]);
+    }
+}
+
+template <class FieldType, class Traits>
+vector<FieldType> OptimizedPSS<FieldType, Traits>::ptToCoeff(vector<FieldType>& samplePoints,int pow_u, bool is_share) {
+    vector<FieldType> n_i;
     n_i.reserve(2*(d+1));
     if (samplePoints.size() != d+1) {
         throw std::invalid_argument("You need at least d+1 points to reconstruct!");
@@ -166,21 +902,20 @@ vector<ZZ_p> OptimizedPSS::ptToCoeff(vector<ZZ_p>& samplePoints,int pow_u, bool
     // the previous steps should have given us the coefficients of the poly N', we eval. at the points r^-j-1 = (r^(j+1))^-1 for j in 0 ... d to get the coefficients of -[P(x)/A(x)]
     computeN(n_i, pow_u);
     if (is_share) {
-        polyMult(n_i, A_share);
+        convolve(n_i, A_share_evals, n_i, conv_workspace, d+1);
     } else {
-        polyMult(n_i, A_recover);
+        convolve(n_i, A_recover_evals, n_i, conv_workspace, d+1);
     }
-    
-    n_i.erase(n_i.begin()+d+1, n_i.end()); 
     return n_i; 
 }
 
-vector<ZZ_p> OptimizedPSS::recoverSS(vector<ZZ_p>& samplePoints) {
+template <class FieldType, class Traits>
+vector<FieldType> OptimizedPSS<FieldType, Traits>::recoverSS(vector<FieldType>& samplePoints) {
     if (samplePoints.size() < d+1) {
         throw std::invalid_argument("Not enough points to recover the secrets!");
     }
     
-    vector<ZZ_p> checkPoints;
+    vector<FieldType> checkPoints;
     int check_num = samplePoints.size() - (d+1);
     if (check_num > 0) {
         for (auto it = samplePoints.begin()+d+1; it != samplePoints.end(); it++) {
@@ -192,8 +927,23 @@ vector<ZZ_p> OptimizedPSS::recoverSS(vector<ZZ_p>& samplePoints) {
     bool isShare = false;
     auto px = ptToCoeff(samplePoints, nearest_pow, isShare);
     prepareCoeffs(px, nearest_pow);
-    DFT(px, nearest_pow); // this is probably just easier
     auto end_of_first_check = check_num+l+d+1 < (1 << nearest_pow-1) ? check_num: (1 << nearest_pow-1) - (l+d+1);
+    auto plan = recover_plans.find(check_num);
+    if (plan == recover_plans.end()) {
+        // the secrets and the check points are all we look at
+        vector<int> outputs;
+        for (int i = 0; i < l; i++) {
+            outputs.push_back(2*i);
+        }
+        for (int i = 0; i < end_of_first_check; i++) {
+            outputs.push_back(2*(l+d+1+i));
+        }
+        for (int i = 0; i < check_num-end_of_first_check; i++) {
+            outputs.push_back(2*i+1);
+        }
+        plan = recover_plans.insert(make_pair(check_num, truncatedPlan(nearest_pow, outputs))).first;
+    }
+    transform(&px[0], nearest_pow, &plan->second, d+1);
     for (int i = 0; i < end_of_first_check; i++) {
         if (px.at(2*(l+d+1+i)) != checkPoints[i]) {
             cout << "Party " << to_string(d+1+i) << " is cheating!" << endl;
@@ -219,77 +969,201 @@ vector<ZZ_p> OptimizedPSS::recoverSS(vector<ZZ_p>& samplePoints) {
     return px;
 }
 
-vector<ZZ_p> OptimizedPSS::multPolyList(vector<vector<ZZ_p>>& polys) {
-    // divide and conquer 
-    if (polys.size() == 1) {
-        return polys[0];
-    } else if (polys.size() == 2) {
-        polyMult(polys[0], polys[1]);
-        return polys[0];
-    } else if (polys.size() == 0) {
-       throw std::invalid_argument("Ah this shouldn't happen!");
-    }
-    
-    int mid_pt = polys.size() / 2;
-    // https://www.tutorialspoint.com/getting-a-subvector-from-a-vector-in-cplusplus
-    vector<vector<ZZ_p>> rhs(polys.begin(), polys.begin()+mid_pt);
-    vector<vector<ZZ_p>> lhs(polys.begin()+mid_pt, polys.end());
-    auto rhs_eval = multPolyList(rhs);
-    auto lhs_eval = multPolyList(lhs);
-    
-    polyMult(rhs_eval, lhs_eval);
-    return rhs_eval;
-}
-
 // a CONTAINS the result of the multiplication
 // b *CAN* be used after this step
 // i.e a is of form a_0 ... a_2^j, b_0 ... b_2^j 
 // the result of this computation is stored in the first argument
-void OptimizedPSS::polyMult(vector<ZZ_p>& a, vector<ZZ_p>& b) {
-    auto num_pts = a.size()+b.size()-1;
-    auto total = (1 << nearest_pow);
-    if (total < num_pts) {
-        cout << "Number of roots is " << total << ". Number of pts needed is " << num_pts << endl;
-        cout << "A polynomial: " << endl;
-        printCV(a);
-        cout << "B polynomial: " << endl;
-        printCV(b); 
-        throw std::invalid_argument("polyMult:: polynomials must be 'small enough'");
-    }
-
-    // convert a and b to pt. eval form
-    prepareCoeffs(a, nearest_pow);
-    DFT(a, nearest_pow);
-    int save_b = b.size();
-    if (b.size() != (1<<nearest_pow)) {
-        prepareCoeffs(b, nearest_pow);
-    } 
-    auto c = PreserveInDFT(b, nearest_pow);
-    //TODO: ensure that n > 2*len(a)
-    // multiply points
-    //vector<ZZ_p> c_pts;
-    //c_pts.reserve(total);    
-    for (int i = 0; i<total; i++) {
-        a[i] = a[i] * c[i]; 
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::polyMult(vector<FieldType>& a, vector<FieldType>& b) {
+    polyMult(a, b, a);
+}
+
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::polyMult(const vector<FieldType>& a, const vector<FieldType>& b, vector<FieldType>& out) {
+    if (a.empty() || b.empty()) {
+        throw std::invalid_argument("polyMult:: empty polynomial");
+    }
+    multiplyInto(&a[0], a.size(), &b[0], b.size(), mult_out);
+    out.swap(mult_out);
+}
+
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::polyMult(const FieldType* a, int la, const FieldType* b, int lb, FieldType* out) {
+    if (la <= 0 || lb <= 0) {
+        throw std::invalid_argument("polyMult:: empty polynomial");
+    }
+    multiplyInto(a, la, b, lb, mult_out);
+    copy(mult_out.begin(), mult_out.end(), out);
+}
+
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::multiplyInto(const FieldType* a, int la, const FieldType* b, int lb, vector<FieldType>& result) {
+    int num_pts = la+lb-1;
+    if (min(la, lb) <= schoolbook_max) {
+        result.resize(num_pts);
+        schoolbookMult(a, la, b, lb, &result[0]);
+    } else if (max(la, lb) <= karatsuba_max || num_pts > (1 << nearest_pow)) {
+        // both operands zero padded to the longer one
+        int m = max(la, lb);
+        auto zero = fieldType->GetElement(0);
+        mult_scratch.resize(4*m + karatsubaScratch(m));
+        FieldType* pa = &mult_scratch[0];
+        FieldType* pb = pa + m;
+        FieldType* prod = pb + m;
+        copy(a, a + la, pa);
+        fill(pa + la, pa + m, zero);
+        copy(b, b + lb, pb);
+        fill(pb + lb, pb + m, zero);
+        karatsubaMult(pa, pb, m, prod, prod + 2*m, schoolbook_max);
+        result.assign(prod, prod + num_pts);
+    } else {
+        FieldType* prod = convolveInto(a, la, b, lb, convolutionLog(num_pts), num_pts, conv_workspace);
+        result.assign(prod, prod + num_pts);
+    }
+}
+
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::monicPolyMult(const FieldType* a, int la, const FieldType* b, int lb, FieldType* out) {
+    int deg = la+lb-2;
+    if (la <= 0 || lb <= 0 || min(la, lb) <= schoolbook_max || max(la, lb) <= karatsuba_max || deg > (1 << nearest_pow)) {
+        polyMult(a, la, b, lb, out);
+        return;
+    }
+    // with 2^pow_u >= deg only the leading x^deg can wrap around, and then onto x^0
+    int pow_u = convolutionLog(deg);
+    auto order_gr = (1 << pow_u);
+    FieldType* prod = convolveInto(a, la, b, lb, pow_u, order_gr, conv_workspace);
+    copy(prod, prod + min(order_gr, deg+1), out);
+    if (deg == order_gr) {
+        out[0] -= fieldType->GetElement(1);
+        out[deg] = fieldType->GetElement(1);
+    }
+}
+
+template <class FieldType, class Traits>
+int OptimizedPSS<FieldType, Traits>::convolutionLog(int num_pts) {
+    int pow_u = 0;
+    while ((1 << pow_u) < num_pts) {
+        pow_u++;
+    }
+    if (pow_u > nearest_pow) {
+        throw std::invalid_argument("convolve:: the product needs more roots of unity than this OptimizedPSS has");
+    }
+    return pow_u;
+}
+
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::convolve(const vector<FieldType>& a, const vector<FieldType>& b,
+                                               vector<FieldType>& out, vector<FieldType>& workspace) {
+    if (a.empty() || b.empty()) {
+        throw std::invalid_argument("convolve:: empty polynomial");
     }
-    InvDFT(a, nearest_pow, num_pts);
-    b.erase(b.begin()+save_b, b.end());
+    int num_pts = a.size()+b.size()-1;
+    FieldType* prod = convolveInto(&a[0], a.size(), &b[0], b.size(), convolutionLog(num_pts), num_pts, workspace);
+    out.assign(prod, prod + num_pts);
 }
 
-vector<ZZ_p> OptimizedPSS::multiplyRoots(vector<int>& root_pos) {
-    vector<vector<ZZ_p>> list_roots(root_pos.size());
+template <class FieldType, class Traits>
+FieldType* OptimizedPSS<FieldType, Traits>::convolveInto(const FieldType* a, int la, const FieldType* b, int lb,
+                                                         int pow_u, int num_pts, vector<FieldType>& workspace) {
+    auto order_gr = (1 << pow_u);
+    if (workspace.size() < 2*order_gr) {
+        workspace.resize(2*order_gr);
+    }
+    FieldType* a_evals = &workspace[0];
+    FieldType* b_evals = a_evals + order_gr;
+    forwardInto(a, la, a_evals, pow_u);
+    forwardInto(b, lb, b_evals, pow_u);
+    NTTKernels<FieldType>::pointwiseMult(a_evals, b_evals, order_gr);
+    // b's evaluations are spent, the coefficients go there
+    inverseInto(a_evals, pow_u, b_evals, num_pts);
+    return b_evals;
+}
+
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::convolve(const vector<FieldType>& a, const CachedTransform<FieldType>& b,
+                                               vector<FieldType>& out, vector<FieldType>& workspace, int out_len) {
+    if (a.empty()) {
+        throw std::invalid_argument("convolve:: empty polynomial");
+    }
+    int num_pts = a.size()+b.length-1;
+    auto order_gr = (1 << b.pow_u);
+    if (num_pts > order_gr) {
+        throw std::invalid_argument("convolve:: the product does not fit in the cached transform");
+    }
+    if (out_len >= 0 && out_len < num_pts) {
+        num_pts = out_len;
+    }
+    if (workspace.size() < 2*order_gr) {
+        workspace.resize(2*order_gr);
+    }
+    FieldType* a_evals = &workspace[0];
+    FieldType* coeffs = a_evals + order_gr;
+    forwardInto(&a[0], a.size(), a_evals, b.pow_u);
+    NTTKernels<FieldType>::pointwiseMult(a_evals, &b.evals[0], order_gr);
+    inverseInto(a_evals, b.pow_u, coeffs, num_pts);
+    out.assign(coeffs, coeffs + num_pts);
+}
+
+template <class FieldType, class Traits>
+CachedTransform<FieldType> OptimizedPSS<FieldType, Traits>::cacheTransform(const vector<FieldType>& b, int pow_u) {
+    if (b.empty() || b.size() > (1 << pow_u)) {
+        throw std::invalid_argument("cacheTransform:: the polynomial does not fit in 2^pow_u points");
+    }
+    CachedTransform<FieldType> cached;
+    cached.pow_u = pow_u;
+    cached.length = b.size();
+    cached.evals.resize(1 << pow_u);
+    forwardInto(&b[0], b.size(), &cached.evals[0], pow_u);
+    return cached;
+}
+
+// the first pass of transform, reading src instead of a copy of dst
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::forwardInto(const FieldType* src, int src_len, FieldType* dst, int pow_u) {
+    auto order_gr = (1 << pow_u);
+    auto zero = fieldType->GetElement(0);
+    src_len = min(src_len, order_gr);
+    if (pow_u < 2 || (codelets && pow_u >= min_codelet_log && pow_u <= max_codelet_log) || fourStepSize(pow_u)) {
+        copy(src, src + src_len, dst);
+        fill(dst + src_len, dst + order_gr, zero);
+        transform(dst, pow_u);
+        return;
+    }
+    auto step = (1 << pow_u - 1);
+    int base = 0;
+    for (int k = 0; k < step; k++) {
+        if (base >= src_len) {
+            dst[2*k] = zero;
+            dst[2*k+1] = zero;
+        } else if (base+step >= src_len) {
+            dst[2*k] = src[base];
+            dst[2*k+1] = src[base];
+        } else {
+            dst[2*k] = src[base] + src[base+step];
+            dst[2*k+1] = src[base] - src[base+step];
+        }
+        if (k+1 < step) {
+            reverse_add(base, pow_u);
+        }
+    }
+    dftLayers(dst, pow_u, nullptr, src_len);
+}
+
+template <class FieldType, class Traits>
+vector<FieldType> OptimizedPSS<FieldType, Traits>::multiplyRoots(vector<int>& root_pos) {
+    vector<FieldType> pts(root_pos.size());
     for (int i = 0 ; i < root_pos.size(); i++) {
-        list_roots[i].push_back(-roots[root_pos[i]]);
-        list_roots[i].push_back(fieldType->GetElement(1));
+        pts[i] = roots[root_pos[i]];
     }
-    auto A = multPolyList(list_roots);
-    return A;
+    SubproductTree<FieldType, Traits> tree(this, pts);
+    return tree.root();
 }
-vector<ZZ_p> generateRoots(ZZ_p & gen, int TOTAL) {
-    vector<ZZ_p> roots;
+template <class FieldType>
+vector<FieldType> generateRoots(FieldType & gen, int TOTAL) {
+    vector<FieldType> roots;
     roots.reserve(1 << TOTAL);
     roots.push_back(power(gen,0));
-    cout << 0 << endl;
     for (int i = 1; i < TOTAL+1; i++) {
         // always fix 2^j-i to be 1 
         for (int j = 0; j < (1<< (i-1)); j++) {
@@ -300,43 +1174,71 @@ vector<ZZ_p> generateRoots(ZZ_p & gen, int TOTAL) {
                     elt = elt + (1 << (TOTAL-1-k));
                 }
             }
-            cout << elt << endl;
             roots.push_back(power(gen,elt));
         }
     }
     return roots;
 }
 
-OptimizedPSS::OptimizedPSS(int l, int d, int n, long field_size, TemplateField<ZZ_p>* field) : l(l), d(d), n(n) {
-    // 3193032821760 = 2^10 * 3^3 * 5 * 19 * 173 * 7027
-    if (field_size != 3193032821761) {
-        throw std::invalid_argument("You must use this with the hardcoded field Z_p of size 3193032821761");
-    }
+template <class FieldType, class Traits>
+OptimizedPSS<FieldType, Traits>::OptimizedPSS(int l, int d, int n, long field_size, TemplateField<FieldType>* field) : l(l), d(d), n(n) {
     fieldType = field;
     nearest_pow = ceil(log2(n+l));
     auto total_num_pts = 1 << nearest_pow;
     roots.reserve(total_num_pts); // the first n+l points are used for the most part in the protocol 
-    if (nearest_pow > 10) {
+    // the field needs 2^nearest_pow | p-1, e.g. 3193032821760 = 2^10 * 3^3 * 5 * 19 * 173 * 7027
+    if (nearest_pow > Traits::twoAdicity(field_size)) {
         throw std::invalid_argument("Number of parties and packed ss are too large for the OptimizedPSS field");
     }
-    auto pow_for_sub = (field_size - 1) / total_num_pts; 
-    generator = power(fieldType->GetElement(14), pow_for_sub); 
+    generator = Traits::rootOfUnity(fieldType, field_size, nearest_pow); 
+    fixed_roots = Traits::fixedRoots(field_size);
+    lazy_reduction = NTTKernels<FieldType>::has_lazy;
+    radix = NTT_RADIX4;
+    codelets = true;
+    // with 8 byte elements the direct loop is compute bound while the array fits in
+    // L2/L3, below that the extra twiddle pass and transpose cost more than they save
+    four_step_log = 20;
+    // a layer of 2^14 points is a few thousand butterflies per thread on a big box,
+    // enough to pay for waking the pool once per layer
+    parallel_log = 14;
+    // where the products of two n coefficient polynomials cross over: schoolbook beats
+    // Karatsuba (cut off at 8) below ~10, Karatsuba beats the product sized DFT up to
+    // ~32 (native) / ~48 (ZZ_p), and the padding to 2^k makes n = 48 a tie natively
+    schoolbook_max = 8;
+    karatsuba_max = 48;
+    subset_cache_max = 64;
+    tables.resize(nearest_pow+1);
+    twiddleTable(nearest_pow);
+    if (nearest_pow > 0) {
+        twiddleTable(nearest_pow-1);
+    }
+    // same index selection as secretShareValues
+    vector<int> share_outputs;
+    int rest_of_pts = n-(d+1-l);
+    int share_end = rest_of_pts + d+1 < (1 << nearest_pow-1) ? rest_of_pts : (1 << nearest_pow-1) - (d+1);
+    for (int i = 0; i < share_end; i++) {
+        share_outputs.push_back(2*(d+1+i));
+    }
+    for (int i = 0; i < (rest_of_pts - share_end); i++) {
+        share_outputs.push_back(2*i+1);
+    }
+    share_plan = truncatedPlan(nearest_pow, share_outputs);
     // order the roots in memory in the most efficient way for memory acceses
     // see https://medium.com/snips-ai/optimizing-threshold-secret-sharing-c877901231e5 by Mathieu Poumeyrol
     //we want all roots of unity for nearest_pow-1 first
-    auto h = power(generator, 2);
+    auto h = Traits::power(generator, 2);
     int half_pts = (1 << nearest_pow-1);
     for (int i = 0; i < half_pts; i++) {
-        roots.push_back(power(h, i));
+        roots.push_back(rootPower(2*i));
     }
     // fill out with the rest of the points
     for (int i = 0; i < half_pts; i++) {
-        roots.push_back(power(generator, 2*i+1));
+        roots.push_back(rootPower(2*i+1));
     }
     if (roots[half_pts-1]*h != roots[0]) {
         cout << "Not a subgroup!" << endl;
     }
-    if (power(generator, total_num_pts) != roots[0]) {
+    if (Traits::power(generator, total_num_pts) != roots[0]) {
         cout << "Not a group!" << endl;
     }
        
@@ -344,7 +1246,7 @@ OptimizedPSS::OptimizedPSS(int l, int d, int n, long field_size, TemplateField<Z
     for (int i = l; i < d+1; i++) {
         shared_roots[i-l] = i;
     }
-    vector<ZZ_p> shared_A = multiplyRoots(shared_roots);
+    vector<FieldType> shared_A = multiplyRoots(shared_roots);
 
     // multiply rest of points used in A_shared?? 
     shared_roots.erase(shared_roots.begin(),shared_roots.end());
@@ -362,16 +1264,23 @@ OptimizedPSS::OptimizedPSS(int l, int d, int n, long field_size, TemplateField<Z
     A_recover = multiplyRoots(recover_roots);
     // shared_A
     polyMult(A_recover, shared_A);
+    // the products in ptToCoeff have 2(d+1) coefficients
+    int cached_pow = 0;
+    while ((1 << cached_pow) < 2*(d+1) && cached_pow < nearest_pow) {
+        cached_pow++;
+    }
+    A_share_evals = cacheTransform(A_share, cached_pow);
+    A_recover_evals = cacheTransform(A_recover, cached_pow);
 
     // calculate A, A', and eval. pts. A'(x_i) = A_i(x_i)
-    //vector<ZZ_p> A_deriv(d+1);
+    //vector<FieldType> A_deriv(d+1);
     // calculate A' the easy way
     
     for (int i = 0; i < d+1; i++) {
         A_pts_recover.push_back(A_recover[i+1] * (i+1));
     }
     // calcuate A_i(x_i)
-    vector<ZZ_p> A_pts_rec_c(A_pts_recover.begin(), A_pts_recover.end());
+    vector<FieldType> A_pts_rec_c(A_pts_recover.begin(), A_pts_recover.end());
     prepareCoeffs(A_pts_rec_c, nearest_pow);
     DFT(A_pts_rec_c, nearest_pow); 
     auto end = l+d+1 < (1 << nearest_pow-1) ? d+1 : ( 1<< nearest_pow-1) - l; 
@@ -396,29 +1305,34 @@ OptimizedPSS::OptimizedPSS(int l, int d, int n, long field_size, TemplateField<Z
     A_pts_share.erase(A_pts_share.begin()+d+1, A_pts_share.end());
     // attempting to do *anything* to make this code faster, pre-computing
     // inverse
-    for (int i = 0; i < d+1; i++) {
-        A_pts_share[i] = inv(A_pts_share[i]);
-        A_pts_recover[i] = inv(A_pts_recover[i]); 
-    }
+    batchInverse(A_pts_share, fieldType->GetElement(1));
+    batchInverse(A_pts_recover, fieldType->GetElement(1));
     
 }
 
-void OptimizedPSS::DFT(vector<ZZ_p>& coeffs, int pow_u, int begin, int end) {
-    DFT(coeffs, pow_u); 
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::DFT(vector<FieldType>& coeffs, int pow_u, int begin, int end) {
+    vector<int> outputs;
+    for (int i = begin; i < end; i++) {
+        outputs.push_back(i);
+    }
+    DFT(coeffs, pow_u, outputs); 
     coeffs.erase(coeffs.begin()+end, coeffs.end());
     coeffs.erase(coeffs.begin(), coeffs.begin()+begin);
     return;
 }
 
-void OptimizedPSS::computeN(vector<ZZ_p>& coeffs, int pow_u) {
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::computeN(vector<FieldType>& coeffs, int pow_u) {
+    int nonzero = coeffs.size();
     prepareCoeffs(coeffs, pow_u);
-    DFT(coeffs, pow_u);
+    PrunedDFT(coeffs, pow_u, nonzero);
     // make sure you grab the d+1 points you need
     auto MASK = (1 << pow_u) - 1;
     //for (int it = 0; it < (1 << (nearest_pow-1)); it++) {
     auto need_saved = (d+1) - (1 << (pow_u-1));
     if (need_saved > 0) {
-        vector<ZZ_p> save_v(need_saved);
+        vector<FieldType> save_v(need_saved);
         int need_nothing = (1 << pow_u-1) - need_saved; 
         for (int it = 0; it < need_nothing; it++) {
             auto one_more_inv = ((1 << pow_u) - it - 1) & MASK;
@@ -444,7 +1358,8 @@ void OptimizedPSS::computeN(vector<ZZ_p>& coeffs, int pow_u) {
     return;    
 }
 
-void OptimizedPSS::prepareCoeffs(vector<ZZ_p>& coeffs, int pow_u) {
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::prepareCoeffs(vector<FieldType>& coeffs, int pow_u) {
     auto zero = fieldType->GetElement(0);
     int total = 1 << pow_u; // 2^j
     coeffs.resize(total, zero);
@@ -456,32 +1371,114 @@ void OptimizedPSS::prepareCoeffs(vector<ZZ_p>& coeffs, int pow_u) {
 // Assumpt.: the coefficients are *sequentially* ordered
 // i.e. input coefficients as a_0 a_1 ... a_2^j-1
 // the OUTPUT is ordered as p(0) p(1) ... p(2^j-1) <- I'm just represeneting elements by their exponent here wrt the generator
-void OptimizedPSS::DFT(vector<ZZ_p>& coeffs, int pow_u) {
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::DFT(vector<FieldType>& coeffs, int pow_u) {
+    transform(&coeffs[0], pow_u);
+}
+
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::DFT(vector<FieldType>& coeffs, int pow_u, const vector<int>& outputs) {
+    TruncatedPlan plan = truncatedPlan(pow_u, outputs);
+    transform(&coeffs[0], pow_u, &plan);
+}
+
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::DFT(vector<FieldType>& coeffs, const TruncatedPlan& plan) {
+    transform(&coeffs[0], plan.pow_u, &plan);
+}
+
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::PrunedDFT(vector<FieldType>& coeffs, int pow_u, int nonzero) {
+    transform(&coeffs[0], pow_u, nullptr, nonzero);
+}
+
+// van der Hoeven's truncated FFT generalized to any output set: walking down from
+// the requested outputs, layer i needs offset k of a block iff some output is k mod 2^i
+template <class FieldType, class Traits>
+TruncatedPlan OptimizedPSS<FieldType, Traits>::truncatedPlan(int pow_u, const vector<int>& outputs) {
+    TruncatedPlan plan;
+    plan.pow_u = pow_u;
+    plan.runs.resize(max(pow_u, 1));
+    vector<bool> needed(1 << pow_u);
+    for (int j = 0; j < outputs.size(); j++) {
+        if (outputs[j] < 0 || outputs[j] >= (1 << pow_u)) {
+            throw std::invalid_argument("Truncated DFT output out of range");
+        }
+    }
+    for (int i = 1; i < pow_u; i++) {
+        auto step = (1 << i);
+        fill(needed.begin(), needed.begin()+step, false);
+        for (int j = 0; j < outputs.size(); j++) {
+            needed[outputs[j] & (step-1)] = true;
+        }
+        for (int k = 0; k < step; ) {
+            if (!needed[k]) {
+                k++;
+                continue;
+            }
+            plan.runs[i].push_back(k);
+            while (k < step && needed[k]) {
+                k++;
+            }
+            plan.runs[i].push_back(k);
+        }
+    }
+    return plan;
+}
+
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::transform(FieldType* coeffs, int pow_u, const TruncatedPlan* plan, int nonzero) {
     auto order_gr = (1 << pow_u);
     auto MASK = order_gr - 1;
-    ZZ_p gen;
-    if (pow_u == nearest_pow) {
-        gen = generator;
-    } else {
-        gen = generator*generator;
+    if (nonzero < 0 || nonzero > order_gr) {
+        nonzero = order_gr;
     }
 
     if (pow_u == 0) {
         return;
     }
+    // a codelet computes every output, for a plan that is a superset
+    if (codelets && pow_u >= min_codelet_log && pow_u <= max_codelet_log) {
+        TwiddleTable<FieldType>& table = twiddleTable(pow_u);
+        runNTTCodelet(pow_u, coeffs, &table.forward[0], table.forward_q.data());
+        return;
+    }
+    // so does the four step transform
+    if (fourStepSize(pow_u)) {
+        fourStep(coeffs, pow_u);
+        return;
+    }
     else if (pow_u == 1) {
         auto save = coeffs[0];
         coeffs[0] = coeffs[0] + coeffs[1];
         coeffs[1] = save - coeffs[1];
         return;
     }
+    if (plan == nullptr && nonzero == order_gr && parallelSize(pow_u)) {
+        // out of place so the pairs are independent, pair k reads coefficients
+        // rev(k) and rev(k)+step
+        auto step = (1 << pow_u - 1);
+        vector<FieldType> scratch_space(coeffs, coeffs + order_gr);
+        runParallel(pow_u, step, [&](int k_begin, int k_end) {
+            int base = bitReverse(k_begin, pow_u - 1);
+            for (int k = k_begin; k < k_end; k++) {
+                coeffs[2*k] = scratch_space[base] + scratch_space[base+step];
+                coeffs[2*k+1] = scratch_space[base] - scratch_space[base+step];
+                if (k+1 < k_end) {
+                    reverse_add(base, pow_u);
+                }
+            }
+        });
+        dftLayersParallel(coeffs, pow_u);
+        return;
+    }
 
     // we're starting off not in the correct order for 
     // the coefficients. if we want to deal with this w.o
     // reordering, we'll need to do something special for the 
     // first run through of the loop 
     auto step = (1 << pow_u - 1);
-    vector<ZZ_p> scratch_space(1 << pow_u); 
+    vector<FieldType> scratch_space(1 << pow_u); 
     int base = 0; 
     for (int k = 0; k < step; k++) {
         // k and k+step are the *coefficients* under consider.
@@ -492,7 +1489,11 @@ void OptimizedPSS::DFT(vector<ZZ_p>& coeffs, int pow_u) {
 
         scratch_space[k_d] = coeffs[k_d];
         scratch_space[k_d+1] = coeffs[k_d+1];
-        if (k_d >= base+step) {
+        if (base+step >= nonzero) {
+            // the second operand is padding, nothing to add
+            coeffs[k_d] = k_d >= base ? scratch_space[base] : coeffs[base];
+            coeffs[k_d+1] = coeffs[k_d];
+        } else if (k_d >= base+step) {
             coeffs[k_d] = scratch_space[base] + scratch_space[base+step];
             coeffs[k_d+1] = scratch_space[base] - scratch_space[base+step];
         } else if (k_d >= base) { 
@@ -507,28 +1508,348 @@ void OptimizedPSS::DFT(vector<ZZ_p>& coeffs, int pow_u) {
         
     } 
 
-    ZZ_p y, factor, stride; 
-    for (int i = 1; i < pow_u; i++) {
-        auto step = (1 << i); // 2^i
-        auto jmp = 2*step; // 2^i+1
-        // factor stride 
-        stride = power(gen, order_gr >> (i+1)); // 2^(j-i-1)
-        factor = fieldType->GetElement(1);
+    dftLayers(coeffs, pow_u, plan, nonzero);
+    return;
+}
+
+// Bailey's four step transform for 2^pow_u = R*C points, R = 2^(pow_u/2). with
+// j = C*j1 + j2 and k = k1 + R*k2,
+// X[k1 + R*k2] = sum_j2 (w^R)^(j2*k2) w^(j2*k1) sum_j1 (w^C)^(j1*k1) a[C*j1 + j2]
+// so with coeffs as an R x C matrix it's a transform of R points down every column,
+// a twiddle pass, a transform of C points along every row and a transpose. the
+// columns are done as batched transforms over strips of columns, so every pass
+// stays inside a strip or a row that fits in cache
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::fourStep(FieldType* coeffs, int pow_u) {
+    auto log_r = pow_u / 2;
+    auto log_c = pow_u - log_r;
+    auto R = (1 << log_r);
+    auto C = (1 << log_c);
+    auto half = (1 << pow_u) >> 1;
+    TwiddleTable<FieldType>& table = twiddleTable(pow_u);
+    if (parallelSize(pow_u)) {
+        // the sub-transforms may recurse, and nothing can be built once the pool runs
+        for (int k = 0; k < pow_u; k++) {
+            twiddleTable(k);
+        }
+    } else {
+        twiddleTable(log_r);
+        twiddleTable(log_c);
+    }
+    const int strip = 16;
+    runParallel(pow_u, (C + strip - 1) / strip, [&](int s_begin, int s_end) {
+        for (int j0 = s_begin*strip; j0 < min(s_end*strip, C); j0 += strip) {
+            dftBatch(coeffs + j0, log_r, min(strip, C - j0), C);
+        }
+    });
+    runParallel(pow_u, R, [&](int k_begin, int k_end) {
+        for (int k1 = max(k_begin, 1); k1 < k_end; k1++) {
+            FieldType* row = coeffs + (size_t) k1*C;
+            for (int j2 = 1; j2 < C; j2++) {
+                // w^e with w^(e + half) = -w^e, from the last layer of the twiddle table
+                auto e = (j2*k1) & (2*half-1);
+                auto idx = e < half ? half+e : e;
+                if (NTTKernels<FieldType>::has_lazy) {
+                    NTTKernels<FieldType>::mulTwiddle(row[j2], table.forward[idx], table.forward_q[idx]);
+                } else {
+                    row[j2] *= table.forward[idx];
+                }
+                if (e >= half) {
+                    row[j2] = -row[j2];
+                }
+            }
+            transform(row, log_c);
+        }
+        if (k_begin == 0 && k_end > 0) {
+            transform(coeffs, log_c);
+        }
+    });
+    // row k1 holds X[k1 + R*k2]
+    vector<FieldType> t(1 << pow_u);
+    const int tile = 16;
+    runParallel(pow_u, (R + tile - 1) / tile, [&](int t_begin, int t_end) {
+        transposeBlocked(coeffs, &t[0], R, C, t_begin*tile, min(t_end*tile, R));
+    });
+    copy(t.begin(), t.end(), coeffs);
+}
+
+template <class FieldType, class Traits>
+TwiddleTable<FieldType>& OptimizedPSS<FieldType, Traits>::twiddleTable(int pow_u) {
+    if (pow_u < 0 || pow_u > nearest_pow) {
+        throw std::invalid_argument("No roots of unity of that order in this OptimizedPSS");
+    }
+    TwiddleTable<FieldType>& table = tables[pow_u];
+    if (table.built) {
+        return table;
+    }
+    auto order_gr = (1 << pow_u);
+    auto half = order_gr >> 1;
+    bool lazy = NTTKernels<FieldType>::has_lazy;
+    table.forward.resize(max(order_gr, 1));
+    table.inverse.resize(max(order_gr, 1));
+    if (lazy) {
+        table.forward_q.resize(table.forward.size());
+        table.inverse_q.resize(table.inverse.size());
+    }
+    // the last layer has every power of the root, the earlier layers are subsamples of it
+    if (fixed_roots) {
+        // the root is w^stride for the compile time w, so these are all lookups
+        auto stride = 1L << (zp_root_table_log - pow_u);
+        for (int k = 0; k < half; k++) {
+            table.forward[half+k] = Traits::fromWord(fieldType, zpRootPower(k*stride));
+            table.inverse[half+k] = Traits::fromWord(fieldType, zpRootPower(-k*stride));
+            if (lazy) {
+                table.forward_q[half+k] = zpRootQuotient(k*stride);
+                table.inverse_q[half+k] = zpRootQuotient(-k*stride);
+            }
+        }
+    } else if (half > 0) {
+        FieldType root = Traits::power(generator, 1 << (nearest_pow - pow_u));
+        FieldType root_inv = Traits::inverse(root);
+        table.forward[half] = fieldType->GetElement(1);
+        table.inverse[half] = fieldType->GetElement(1);
+        for (int k = 1; k < half; k++) {
+            table.forward[half+k] = table.forward[half+k-1] * root;
+            table.inverse[half+k] = table.inverse[half+k-1] * root_inv;
+        }
+        if (lazy) {
+            for (int k = 0; k < half; k++) {
+                table.forward_q[half+k] = NTTKernels<FieldType>::shoupQuotient(table.forward[half+k]);
+                table.inverse_q[half+k] = NTTKernels<FieldType>::shoupQuotient(table.inverse[half+k]);
+            }
+        }
+    }
+    for (int step = half >> 1; step > 0; step >>= 1) {
+        auto stride = half / step;
         for (int k = 0; k < step; k++) {
-            auto base = k;
-            while (base < order_gr) { 
-                // pair spots are step apart 
-                // j*jmp +k,  +k + step
-                y = factor * coeffs[base+step]; 
-                // update coefficients
-                coeffs[base+step] = coeffs[base] - y;
-                coeffs[base] += y;
-                base += jmp;
-           }
-           factor = factor * stride;
-        }     
+            table.forward[step+k] = table.forward[half + k*stride];
+            table.inverse[step+k] = table.inverse[half + k*stride];
+            if (lazy) {
+                table.forward_q[step+k] = table.forward_q[half + k*stride];
+                table.inverse_q[step+k] = table.inverse_q[half + k*stride];
+            }
+        }
+    }
+    if (fixed_roots) {
+        table.n_inv = Traits::fromWord(fieldType, zpInverseTwoPower(pow_u));
+    } else {
+        table.n_inv = Traits::inverse(fieldType->GetElement(order_gr));
+    }
+    if (lazy) {
+        table.n_inv_q = NTTKernels<FieldType>::shoupQuotient(table.n_inv);
+    }
+    table.built = true;
+    return table;
+}
+
+// the decimation in time layers 1 ... pow_u-1 shared by DFT and PreserveInDFT.
+// a layer is a run of butterfly blocks that all read the same twiddles w^0 ... w^step-1,
+// so the kernels can stream through contiguous x, y and twiddle arrays. with a plan
+// only the offset ranges it lists are done in each block.
+// when the input is zero from index nonzero on: the x half of block b in layer i
+// comes from the inputs congruent to rev(b) mod 2^(pow_u-i), the y half from the ones
+// congruent to rev(b) + 2^(pow_u-i-1). if the y half only has padding the butterflies
+// collapse into a copy, if the x half does too the block is still all zeros
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::dftLayers(FieldType* out, int pow_u, const TruncatedPlan* plan, int nonzero) {
+    auto order_gr = (1 << pow_u);
+    if (nonzero < 0 || nonzero > order_gr) {
+        nonzero = order_gr;
+    }
+    // values stay in [0, 4p) between lazy layers, only the outputs get reduced
+    bool lazy = lazy_reduction && NTTKernels<FieldType>::has_lazy;
+    // the full transform skips the per block bookkeeping, the early layers are
+    // mostly tiny blocks
+    bool whole = plan == nullptr && nonzero == order_gr;
+    if (whole && parallelSize(pow_u)) {
+        dftLayersParallel(out, pow_u);
+        return;
+    }
+    TwiddleTable<FieldType>& table = twiddleTable(pow_u);
+    const FieldType* w = &table.forward[0];
+    const uint64_t* wq = lazy ? &table.forward_q[0] : nullptr;
+    for (int i = 1; i < pow_u; ) {
+        auto h = (1 << i);
+        if (radix == NTT_RADIX4 && i+1 < pow_u) {
+            for (int base = 0; base < order_gr; base += 4*h) {
+                if (!whole) {
+                    dftBlock4(out, pow_u, i, base, plan, nonzero, lazy);
+                } else if (lazy) {
+                    FieldType* x = out+base;
+                    NTTKernels<FieldType>::lazyRadix4Butterfly(x, x+h, x+2*h, x+3*h, w+h, w+2*h, w+3*h,
+                                                               wq+h, wq+2*h, wq+3*h, h);
+                } else {
+                    FieldType* x = out+base;
+                    NTTKernels<FieldType>::radix4Butterfly(x, x+h, x+2*h, x+3*h, w+h, w+2*h, w+3*h, h);
+                }
+            }
+            i += 2;
+        } else {
+            for (int base = 0; base < order_gr; base += 2*h) {
+                if (!whole) {
+                    dftBlock(out, pow_u, i, base, plan, nonzero, lazy);
+                } else if (lazy) {
+                    NTTKernels<FieldType>::lazyButterfly(out+base, out+base+h, w+h, wq+h, h);
+                } else {
+                    NTTKernels<FieldType>::butterfly(out+base, out+base+h, w+h, h);
+                }
+            }
+            i++;
+        }
+    }
+    if (lazy) {
+        NTTKernels<FieldType>::normalize(out, order_gr);
+    }
+}
+
+// the same layers as the whole transform in dftLayers, with each layer's order_gr/2
+// (radix-2) or order_gr/4 (radix-4) butterflies split evenly over the pool
+// whatever the block size: butterfly u is offset u mod h of block u / h
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::dftLayersParallel(FieldType* out, int pow_u) {
+    auto order_gr = (1 << pow_u);
+    bool lazy = lazy_reduction && NTTKernels<FieldType>::has_lazy;
+    TwiddleTable<FieldType>& table = twiddleTable(pow_u);
+    const FieldType* w = &table.forward[0];
+    const uint64_t* wq = lazy ? &table.forward_q[0] : nullptr;
+    for (int i = 1; i < pow_u; ) {
+        auto h = (1 << i);
+        bool four = radix == NTT_RADIX4 && i+1 < pow_u;
+        auto width = four ? 4*h : 2*h;
+        runParallel(pow_u, order_gr / width * h, [&](int u, int u_end) {
+            while (u < u_end) {
+                auto k = u & (h-1);
+                auto len = min(h - k, u_end - u);
+                FieldType* x = out + (u >> i)*width + k;
+                if (four && lazy) {
+                    NTTKernels<FieldType>::lazyRadix4Butterfly(x, x+h, x+2*h, x+3*h, w+h+k, w+2*h+k, w+3*h+k,
+                                                               wq+h+k, wq+2*h+k, wq+3*h+k, len);
+                } else if (four) {
+                    NTTKernels<FieldType>::radix4Butterfly(x, x+h, x+2*h, x+3*h, w+h+k, w+2*h+k, w+3*h+k, len);
+                } else if (lazy) {
+                    NTTKernels<FieldType>::lazyButterfly(x, x+h, w+h+k, wq+h+k, len);
+                } else {
+                    NTTKernels<FieldType>::butterfly(x, x+h, w+h+k, len);
+                }
+                u += len;
+            }
+        });
+        i += four ? 2 : 1;
+    }
+    if (lazy) {
+        runParallel(pow_u, order_gr, [&](int begin, int end) {
+            NTTKernels<FieldType>::normalize(out + begin, end - begin);
+        });
+    }
+}
+
+template <class FieldType, class Traits>
+FieldType OptimizedPSS<FieldType, Traits>::rootPower(int e) {
+    TwiddleTable<FieldType>& table = twiddleTable(nearest_pow);
+    auto order_gr = (1 << nearest_pow);
+    auto half = order_gr >> 1;
+    e &= order_gr - 1;
+    if (half == 0) {
+        return fieldType->GetElement(1);
+    }
+    // generator^(e + half) = -generator^e
+    return e < half ? table.forward[half+e] : -table.forward[e];
+}
+
+template <class FieldType, class Traits>
+bool OptimizedPSS<FieldType, Traits>::parallelSize(int pow_u) {
+    return thread_pool && thread_pool->size() > 1 && pow_u >= parallel_log;
+}
+
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::runParallel(int pow_u, int count, const function<void(int, int)>& body) {
+    if (!parallelSize(pow_u)) {
+        body(0, count);
+        return;
+    }
+    typename Traits::ThreadContext context;
+    context.save();
+    thread_pool->parallelFor(count, [&](int begin, int end) {
+        context.restore();
+        body(begin, end);
+    });
+}
+
+// the butterflies of layer i in the block starting at base
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::dftBlock(FieldType* out, int pow_u, int i, int base, const TruncatedPlan* plan, int nonzero, bool lazy) {
+    auto step = (1 << i); // 2^i
+    if (nonzero < (1 << pow_u)) {
+        auto bits = pow_u-i-1;
+        auto rev = bitReverse(base >> (i+1), bits);
+        if (rev >= nonzero) {
+            return;
+        }
+        if (rev + (1 << bits) >= nonzero) {
+            copy(out+base, out+base+step, out+base+step);
+            return;
+        }
+    }
+    TwiddleTable<FieldType>& table = tables[pow_u];
+    const FieldType* w = &table.forward[step];
+    const uint64_t* wq = lazy ? &table.forward_q[step] : nullptr;
+    // pair spots are step apart 
+    int whole[2] = {0, step};
+    const int* runs = whole;
+    int num_runs = 1;
+    if (plan != nullptr) {
+        runs = plan->runs[i].data();
+        num_runs = plan->runs[i].size() / 2;
+    }
+    for (int r = 0; r < num_runs; r++) {
+        auto k = runs[2*r];
+        auto len = runs[2*r+1] - k;
+        if (lazy) {
+            NTTKernels<FieldType>::lazyButterfly(out+base+k, out+base+step+k, w+k, wq+k, len);
+        } else {
+            NTTKernels<FieldType>::butterfly(out+base+k, out+base+step+k, w+k, len);
+        }
+    }
+}
+
+// layers i and i+1 of the block of 4*2^i starting at base in one pass. a block that
+// takes in padding goes through dftBlock instead so the zero handling stays in one place
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::dftBlock4(FieldType* out, int pow_u, int i, int base, const TruncatedPlan* plan, int nonzero, bool lazy) {
+    auto h = (1 << i);
+    if (nonzero < (1 << pow_u)) {
+        // the last quarter comes from the inputs with the largest smallest index
+        auto bits = pow_u-i-2;
+        auto rev = bitReverse(base >> (i+2), bits);
+        if (rev + (1 << bits) + (1 << (bits+1)) >= nonzero) {
+            dftBlock(out, pow_u, i, base, plan, nonzero, lazy);
+            dftBlock(out, pow_u, i, base+2*h, plan, nonzero, lazy);
+            dftBlock(out, pow_u, i+1, base, plan, nonzero, lazy);
+            return;
+        }
+    }
+    TwiddleTable<FieldType>& table = tables[pow_u];
+    const FieldType* w = &table.forward[0];
+    const uint64_t* wq = lazy ? &table.forward_q[0] : nullptr;
+    // the layer i+1 butterflies needed by a plan are all k or k+h for a layer i butterfly k
+    int whole[2] = {0, h};
+    const int* runs = whole;
+    int num_runs = 1;
+    if (plan != nullptr) {
+        runs = plan->runs[i].data();
+        num_runs = plan->runs[i].size() / 2;
+    }
+    FieldType* x = out+base;
+    for (int r = 0; r < num_runs; r++) {
+        auto k = runs[2*r];
+        auto len = runs[2*r+1] - k;
+        if (lazy) {
+            NTTKernels<FieldType>::lazyRadix4Butterfly(x+k, x+h+k, x+2*h+k, x+3*h+k, w+h+k, w+2*h+k, w+3*h+k,
+                                                       wq+h+k, wq+2*h+k, wq+3*h+k, len);
+        } else {
+            NTTKernels<FieldType>::radix4Butterfly(x+k, x+h+k, x+2*h+k, x+3*h+k, w+h+k, w+2*h+k, w+3*h+k, len);
+        }
     }
-    return;
 }
 
 // increments itr by 2^j-2 following  the rule that 
@@ -536,7 +1857,8 @@ void OptimizedPSS::DFT(vector<ZZ_p>& coeffs, int pow_u) {
 // this MUST be called with the correct values so that ind does not become
 // neg
 // pow MUST NOT be less than 2 
-void OptimizedPSS::reverse_add(int& itr, int pow) {
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::reverse_add(int& itr, int pow) {
     auto carry = (itr >> pow-2) & 1 + 1;
     int ind = pow-2;
     while ((((itr >> ind) & 1) + 1)  == 2) {
@@ -549,17 +1871,31 @@ void OptimizedPSS::reverse_add(int& itr, int pow) {
 
 // same as the version above, except we want to preserve the input
 // it is assumed that coeffs.size() == ( 1 << nearest_pow)
-vector<ZZ_p> OptimizedPSS::PreserveInDFT(vector<ZZ_p>& coeffs, int pow_u) {
+template <class FieldType, class Traits>
+vector<FieldType> OptimizedPSS<FieldType, Traits>::PreserveInDFT(vector<FieldType>& coeffs, int pow_u) {
+    return PreserveInDFT(coeffs, pow_u, 1 << pow_u);
+}
+
+template <class FieldType, class Traits>
+vector<FieldType> OptimizedPSS<FieldType, Traits>::PreserveInDFT(vector<FieldType>& coeffs, int pow_u, int nonzero) {
     auto order_gr = (1 << pow_u);
     auto MASK = order_gr - 1;
-    ZZ_p gen;
-    if (pow_u == nearest_pow) {
-        gen = generator;
-    } else {
-        gen = generator*generator;
+    if (nonzero < 0 || nonzero > order_gr) {
+        nonzero = order_gr;
+    }
+
+    if ((codelets && pow_u >= min_codelet_log && pow_u <= max_codelet_log) || fourStepSize(pow_u)) {
+        vector<FieldType> out(coeffs.begin(), coeffs.begin() + order_gr);
+        if (fourStepSize(pow_u)) {
+            fourStep(&out[0], pow_u);
+            return out;
+        }
+        TwiddleTable<FieldType>& table = twiddleTable(pow_u);
+        runNTTCodelet(pow_u, &out[0], &table.forward[0], table.forward_q.data());
+        return out;
     }
 
-    vector<ZZ_p> out(order_gr);
+    vector<FieldType> out(order_gr);
     if (pow_u == 0) {
         out[0] = coeffs[0];
         return out;
@@ -583,60 +1919,116 @@ vector<ZZ_p> OptimizedPSS::PreserveInDFT(vector<ZZ_p>& coeffs, int pow_u) {
         // and since we will need it (shortly), we MUST save it somewhere
         auto k_d = 2*k;
 
-        out[k_d] = coeffs[base] + coeffs[base+step];
-        out[k_d+1] = coeffs[base] - coeffs[base+step]; 
+        if (base+step >= nonzero) {
+            out[k_d] = coeffs[base];
+            out[k_d+1] = coeffs[base];
+        } else {
+            out[k_d] = coeffs[base] + coeffs[base+step];
+            out[k_d+1] = coeffs[base] - coeffs[base+step]; 
+        }
 
         reverse_add(base, pow_u); 
     } 
     
-    ZZ_p y, stride, factor; 
-    for (int i = 1; i < pow_u; i++) {
-        auto step = (1 << i); // 2^i
-        auto jmp = 2*step; // 2^i+1
-        // factor stride 
-        stride = power(gen, order_gr >> (i+1)); // 2^(j-i-1)
-        factor = fieldType->GetElement(1);
-        for (int k = 0; k < step; k++) {
-            auto base = k;
-            while (base < order_gr) { 
-                // pair spots are step apart 
-                // j*jmp +k,  +k + step
-                y = factor * out[base+step]; 
-                // update coefficients
-                out[base+step] = out[base] - y;
-                out[base] += y;
-                base += jmp;
-           }
-           factor = factor * stride;
-        }     
-    }
+    dftLayers(&out[0], pow_u, nullptr, nonzero);
     return out; 
 }
 
-void OptimizedPSS::InvDFT(vector<ZZ_p>& sample_pts, int pow_u, int end) {
-    DFT(sample_pts, pow_u);
-    // multiply 1/(1 << nearest_pow) 
-    ZZ_p n_inv = inv(fieldType->GetElement(1<<pow_u));
-    int MASK = (1 << pow_u) - 1;
-    
-    if (end <  1 << (pow_u - 1)) {
-        for (int i = 0; i < end; i++) {
-            int new_idx = ((1 << pow_u) - i) & MASK; 
-            sample_pts[i] = n_inv * sample_pts[new_idx];
-        }
-    } else {
-        for (int i = 0; i < 1 << (pow_u-1); i++) {
-            auto save = sample_pts[i];
-            int new_idx = ((1 << pow_u) - i) & MASK; 
-            sample_pts[i] = n_inv * sample_pts[new_idx];
-            sample_pts[new_idx] = n_inv * save;
-        }
-        sample_pts[1 << (pow_u-1)] *= n_inv; 
+// Gentleman-Sande decimation in frequency with the inverse twiddles, so it takes the
+// evaluations in the natural order DFT leaves them in. the coefficients come out of the
+// last layer in bit reversed order, that layer multiplies by 1/(1 << pow_u) on the way
+// and writes each of them straight to its slot in inv_scratch, skipping the ones past end
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::InvDFT(vector<FieldType>& sample_pts, int pow_u, int end) {
+    if (pow_u == 0) {
+        sample_pts.erase(sample_pts.begin() + end, sample_pts.end());
+        return;
     }
+    inv_scratch.resize(1 << pow_u);
+    inverseInto(&sample_pts[0], pow_u, &inv_scratch[0], end);
+    sample_pts.swap(inv_scratch);
     sample_pts.erase(sample_pts.begin() + end, sample_pts.end());
     return;
 }
 
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::inverseInto(FieldType* in, int pow_u, FieldType* out, int end) {
+    auto order_gr = (1 << pow_u);
+    TwiddleTable<FieldType>& table = twiddleTable(pow_u);
+    if (pow_u == 0) {
+        out[0] = in[0];
+        return;
+    }
+    const FieldType* w = &table.inverse[0];
+    bool lazy = lazy_reduction && NTTKernels<FieldType>::has_lazy;
+    // values stay in [0, 2p) between lazy layers
+    const uint64_t* wq = lazy ? &table.inverse_q[0] : nullptr;
+    for (int i = pow_u-1; i > 0; i--) {
+        auto step = (1 << i);
+        for (int base = 0; base < order_gr; base += 2*step) {
+            if (lazy) {
+                NTTKernels<FieldType>::lazyGSButterfly(in+base, in+base+step, w+step, wq+step, step);
+            } else {
+                NTTKernels<FieldType>::gsButterfly(in+base, in+base+step, w+step, step);
+            }
+        }
+    }
+    auto half = order_gr >> 1;
+    // positions 2k and 2k+1 hold the coefficients rev(k) and rev(k) + half
+    int rev = 0;
+    for (int k = 0; k < half; k++) {
+        if (rev < end) {
+            NTTKernels<FieldType>::scaledButterfly(in[2*k], in[2*k+1], out[rev], out[rev+half], table.n_inv, table.n_inv_q);
+        }
+        if (k+1 < half) {
+            reverse_add(rev, pow_u);
+        }
+    }
+}
+
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::DFTBatch(vector<FieldType>& data, int pow_u, int batch) {
+    if (batch <= 0 || data.size() != ((size_t) 1 << pow_u) * batch) {
+        throw std::invalid_argument("DFTBatch needs (1 << pow_u) rows of batch values");
+    }
+    dftBatch(&data[0], pow_u, batch, batch);
+}
+
+// batch transforms whose element i is at rows[i*stride + b]. every butterfly works on
+// two rows of batch values with one twiddle, so the kernels run over contiguous memory
+// at any layer and each twiddle is loaded once per row
+template <class FieldType, class Traits>
+void OptimizedPSS<FieldType, Traits>::dftBatch(FieldType* rows, int pow_u, int batch, size_t stride) {
+    auto order_gr = (1 << pow_u);
+    TwiddleTable<FieldType>& table = twiddleTable(pow_u);
+    for (int i = 0; i < order_gr; i++) {
+        auto r = bitReverse(i, pow_u);
+        if (i < r) {
+            swap_ranges(rows + i*stride, rows + i*stride + batch, rows + r*stride);
+        }
+    }
+    bool lazy = lazy_reduction && NTTKernels<FieldType>::has_lazy;
+    for (int i = 0; i < pow_u; i++) {
+        auto step = (1 << i);
+        for (int base = 0; base < order_gr; base += 2*step) {
+            for (int k = 0; k < step; k++) {
+                FieldType* x = rows + (base+k)*stride;
+                FieldType* y = x + step*stride;
+                if (lazy) {
+                    NTTKernels<FieldType>::lazyBroadcastButterfly(x, y, table.forward[step+k], table.forward_q[step+k], batch);
+                } else {
+                    NTTKernels<FieldType>::broadcastButterfly(x, y, table.forward[step+k], batch);
+                }
+            }
+        }
+    }
+    if (lazy) {
+        for (int i = 0; i < order_gr; i++) {
+            NTTKernels<FieldType>::normalize(rows + i*stride, batch);
+        }
+    }
+}
+
 template <class FieldType>
 class PackedSecretShare {
 private:
@@ -811,4 +2203,6 @@ vector<FieldType> PackedSecretShare<FieldType>::calcMinPoly(HIM<FieldType>* him)
 }
 
 
+#include "SubproductTree.hpp"
+
 #endif
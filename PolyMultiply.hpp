@@ -0,0 +1,79 @@
+// becgabri (10/17/2026)
+
+#ifndef POLYMULTIPLY_H
+#define POLYMULTIPLY_H
+
+#include <algorithm>
+
+using namespace std;
+
+// Transform free polynomial products for the operand sizes where a DFT costs more
+// than it saves, see OptimizedPSS::polyMult for the dispatch. Coefficients are in
+// increasing degree, out gets la+lb-1 entries and must not overlap a or b
+
+template <class FieldType>
+void schoolbookMult(const FieldType* a, int la, const FieldType* b, int lb, FieldType* out) {
+    // row a[0] and column b[lb-1] set every entry once, the rest accumulates
+    for (int k = 0; k < lb; k++) {
+        out[k] = a[0] * b[k];
+    }
+    for (int i = 1; i < la; i++) {
+        out[i+lb-1] = a[i] * b[lb-1];
+    }
+    for (int i = 1; i < la; i++) {
+        for (int k = 0; k < lb-1; k++) {
+            out[i+k] += a[i] * b[k];
+        }
+    }
+}
+
+// scratch entries karatsubaMult needs for n coefficient operands
+inline int karatsubaScratch(int n) {
+    int total = 0;
+    while (n > 1) {
+        n -= n/2;
+        total += 4*n;
+    }
+    return total;
+}
+
+// a*b for two n coefficient operands, split into low halves of n/2 and high halves
+// of n - n/2 coefficients: a*b = z0 + (z1 - z0 - z2) x^(n/2) + z2 x^(2(n/2)) with
+// z1 = (a_lo + a_hi)(b_lo + b_hi). below cutoff coefficients it is schoolbook
+template <class FieldType>
+void karatsubaMult(const FieldType* a, const FieldType* b, int n, FieldType* out, FieldType* scratch, int cutoff) {
+    if (n <= max(cutoff, 1)) {
+        schoolbookMult(a, n, b, n, out);
+        return;
+    }
+    int lo = n/2;
+    int hi = n - lo;
+    FieldType* sa = scratch;
+    FieldType* sb = sa + hi;
+    FieldType* z1 = sb + hi;
+    FieldType* rest = z1 + 2*hi;
+    // z0 in out[0, 2lo-1), z2 in out[2lo, 2n-1), and the slot between them is 0
+    karatsubaMult(a, b, lo, out, rest, cutoff);
+    karatsubaMult(a + lo, b + lo, hi, out + 2*lo, rest, cutoff);
+    out[2*lo-1] = a[0] - a[0];
+    for (int i = 0; i < lo; i++) {
+        sa[i] = a[i] + a[lo+i];
+        sb[i] = b[i] + b[lo+i];
+    }
+    if (hi > lo) {
+        sa[lo] = a[n-1];
+        sb[lo] = b[n-1];
+    }
+    karatsubaMult(sa, sb, hi, z1, rest, cutoff);
+    for (int i = 0; i < 2*lo-1; i++) {
+        z1[i] -= out[i];
+    }
+    for (int i = 0; i < 2*hi-1; i++) {
+        z1[i] -= out[2*lo+i];
+    }
+    for (int i = 0; i < 2*hi-1; i++) {
+        out[lo+i] += z1[i];
+    }
+}
+
+#endif
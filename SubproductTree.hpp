@@ -0,0 +1,253 @@
+// becgabri (10/17/2026)
+
+#ifndef SUBPRODUCTTREE_H
+#define SUBPRODUCTTREE_H
+
+#include "PackedSS.hpp"
+
+using namespace std;
+
+// Subproduct tree over the points x_0 ... x_{k-1}. Node m of level j is the monic
+// prod (x - x_i) over the points [m 2^j, min((m+1) 2^j, k)): level 0 holds the
+// linear factors, level j+1 the products of pairs of level j nodes, and an odd node
+// out is carried up as it is. Each level is one flat vector with node m at
+// m (2^j + 1), and the products go through OptimizedPSS::monicPolyMult, so the
+// nodes of 2^j points are multiplied with 2^(j+1) point transforms. evaluate walks
+// remainders down the tree and interpolate combines the weighted values up it,
+// O(M(k) log k) each
+template <class FieldType, class Traits>
+class SubproductTree {
+public:
+    SubproductTree(OptimizedPSS<FieldType, Traits>* engine, const vector<FieldType>& points);
+    int size() const { return points.size(); }
+    // prod (x - x_i), k+1 coefficients
+    vector<FieldType> root() const;
+    // f(x_0) ... f(x_{k-1}), f of any degree
+    vector<FieldType> evaluate(const vector<FieldType>& f);
+    // the polynomial of degree < k with p(x_i) = values[i], the points must be distinct
+    vector<FieldType> interpolate(const vector<FieldType>& values);
+    // the barycentric weights 1 / prod_{j != i} (x_i - x_j)
+    const vector<FieldType>& barycentricWeights();
+
+    vector<FieldType> points;
+
+private:
+    OptimizedPSS<FieldType, Traits>* engine;
+    vector<vector<FieldType> > levels;
+    // 1 / prod_{j != i} (x_i - x_j), built on first use
+    vector<FieldType> weights;
+    // rev(node)^-1 mod x^precision for the divisions by each node, built on demand
+    vector<vector<vector<FieldType> > > rev_inverses;
+    vector<FieldType> prod_scratch;
+    vector<FieldType> prod_scratch2;
+    // below this many multiplications a division is done the long way, past it the
+    // Newton inverse and two products are cheaper
+    static const int long_division_max = 4096;
+    // nodes of at most this many points are evaluated by Horner's rule
+    static const int horner_points = 8;
+
+    int nodeCount(int j) const { return (size() + (1 << j) - 1) >> j; }
+    int nodePoints(int j, int m) const { return min((m+1) << j, size()) - (m << j); }
+    const FieldType* node(int j, int m) const { return &levels[j][(size_t) m*((1 << j) + 1)]; }
+    void descend(int j, int m, vector<FieldType>& r, vector<FieldType>& values);
+    void remainder(vector<FieldType>& f, int j, int m);
+    void reverseInverse(const FieldType* g, int t, int precision, vector<FieldType>& h);
+};
+
+template <class FieldType, class Traits>
+SubproductTree<FieldType, Traits>::SubproductTree(OptimizedPSS<FieldType, Traits>* engine, const vector<FieldType>& points)
+    : points(points), engine(engine) {
+    if (points.empty()) {
+        throw std::invalid_argument("SubproductTree:: no points");
+    }
+    int k = size();
+    levels.push_back(vector<FieldType>(2*k));
+    for (int i = 0; i < k; i++) {
+        levels[0][2*i] = -points[i];
+        levels[0][2*i+1] = engine->fieldType->GetElement(1);
+    }
+    for (int j = 0; nodeCount(j) > 1; j++) {
+        int count = nodeCount(j+1);
+        int stride = (1 << (j+1)) + 1;
+        levels.push_back(vector<FieldType>((size_t) count*stride));
+        for (int m = 0; m < count; m++) {
+            FieldType* out = &levels[j+1][(size_t) m*stride];
+            int tl = nodePoints(j, 2*m);
+            if (2*m+1 < nodeCount(j)) {
+                engine->monicPolyMult(node(j, 2*m), tl+1, node(j, 2*m+1), nodePoints(j, 2*m+1)+1, out);
+            } else {
+                copy(node(j, 2*m), node(j, 2*m) + tl+1, out);
+            }
+        }
+    }
+    rev_inverses.resize(levels.size());
+    for (int j = 0; j < levels.size(); j++) {
+        rev_inverses[j].resize(nodeCount(j));
+    }
+}
+
+template <class FieldType, class Traits>
+vector<FieldType> SubproductTree<FieldType, Traits>::root() const {
+    const FieldType* top = node(levels.size()-1, 0);
+    return vector<FieldType>(top, top + size()+1);
+}
+
+template <class FieldType, class Traits>
+vector<FieldType> SubproductTree<FieldType, Traits>::evaluate(const vector<FieldType>& f) {
+    vector<FieldType> values(size(), engine->fieldType->GetElement(0));
+    if (f.empty()) {
+        return values;
+    }
+    vector<FieldType> r(f);
+    int top = levels.size()-1;
+    remainder(r, top, 0);
+    descend(top, 0, r, values);
+    return values;
+}
+
+template <class FieldType, class Traits>
+void SubproductTree<FieldType, Traits>::descend(int j, int m, vector<FieldType>& r, vector<FieldType>& values) {
+    int t = nodePoints(j, m);
+    int first = m << j;
+    if (j == 0 || t <= horner_points) {
+        for (int i = first; i < first+t; i++) {
+            auto value = engine->fieldType->GetElement(0);
+            for (int c = (int) r.size()-1; c >= 0; c--) {
+                value = value*points[i] + r[c];
+            }
+            values[i] = value;
+        }
+        return;
+    }
+    if (2*m+1 >= nodeCount(j-1)) {
+        // carried up, the child is the same polynomial
+        descend(j-1, 2*m, r, values);
+        return;
+    }
+    vector<FieldType> r_right(r);
+    remainder(r, j-1, 2*m);
+    descend(j-1, 2*m, r, values);
+    remainder(r_right, j-1, 2*m+1);
+    descend(j-1, 2*m+1, r_right, values);
+}
+
+// f = f mod node (j, m)
+template <class FieldType, class Traits>
+void SubproductTree<FieldType, Traits>::remainder(vector<FieldType>& f, int j, int m) {
+    int t = nodePoints(j, m);
+    int len = f.size();
+    if (len <= t) {
+        return;
+    }
+    const FieldType* g = node(j, m);
+    int q = len - t;
+    if ((long) q*t <= long_division_max) {
+        // g is monic, so no inversions
+        for (int i = len-1; i >= t; i--) {
+            auto c = f[i];
+            for (int k = 0; k < t; k++) {
+                f[i-t+k] -= c*g[k];
+            }
+        }
+        f.resize(t);
+        return;
+    }
+    // quotient = rev(rev(f) rev(g)^-1 mod x^q)
+    vector<FieldType>& h = rev_inverses[j][m];
+    if (h.size() < q) {
+        reverseInverse(g, t, q, h);
+    }
+    vector<FieldType> f_rev(f.rbegin(), f.rbegin() + q);
+    prod_scratch.resize(2*q-1);
+    engine->polyMult(&f_rev[0], q, &h[0], q, &prod_scratch[0]);
+    vector<FieldType> quotient(prod_scratch.rend() - q, prod_scratch.rend());
+    // only the low t coefficients of quotient*g survive
+    int lq = min(q, t);
+    prod_scratch.resize(lq+t-1);
+    engine->polyMult(&quotient[0], lq, g, t, &prod_scratch[0]);
+    for (int i = 0; i < t; i++) {
+        f[i] -= prod_scratch[i];
+    }
+    f.resize(t);
+}
+
+// h = rev(g)^-1 mod x^precision for g monic of degree t, rev(g) starts with 1 so
+// Newton's iteration h = h (2 - rev(g) h) needs no inversions
+template <class FieldType, class Traits>
+void SubproductTree<FieldType, Traits>::reverseInverse(const FieldType* g, int t, int precision, vector<FieldType>& h) {
+    auto zero = engine->fieldType->GetElement(0);
+    auto two = engine->fieldType->GetElement(2);
+    vector<FieldType> g_rev(t+1);
+    for (int i = 0; i <= t; i++) {
+        g_rev[i] = g[t-i];
+    }
+    h.assign(1, engine->fieldType->GetElement(1));
+    for (int cur = 1; cur < precision; ) {
+        int next = min(2*cur, precision);
+        int lg = min(t+1, next);
+        prod_scratch.resize(lg+cur-1);
+        engine->polyMult(&g_rev[0], lg, &h[0], cur, &prod_scratch[0]);
+        prod_scratch.resize(next, zero);
+        for (int i = 0; i < next; i++) {
+            prod_scratch[i] = -prod_scratch[i];
+        }
+        prod_scratch[0] += two;
+        prod_scratch2.resize(cur+next-1);
+        engine->polyMult(&h[0], cur, &prod_scratch[0], next, &prod_scratch2[0]);
+        h.assign(prod_scratch2.begin(), prod_scratch2.begin() + next);
+        cur = next;
+    }
+}
+
+template <class FieldType, class Traits>
+const vector<FieldType>& SubproductTree<FieldType, Traits>::barycentricWeights() {
+    if (weights.empty()) {
+        // prod_{j != i} (x_i - x_j) is the derivative of the root at x_i
+        vector<FieldType> top = root();
+        vector<FieldType> deriv(size());
+        for (int i = 0; i < size(); i++) {
+            deriv[i] = top[i+1] * engine->fieldType->GetElement(i+1);
+        }
+        weights = evaluate(deriv);
+        batchInverse(weights, engine->fieldType->GetElement(1));
+    }
+    return weights;
+}
+
+template <class FieldType, class Traits>
+vector<FieldType> SubproductTree<FieldType, Traits>::interpolate(const vector<FieldType>& values) {
+    int k = size();
+    if (values.size() != k) {
+        throw std::invalid_argument("SubproductTree:: need one value per point");
+    }
+    barycentricWeights();
+    // level j holds the numerator of every node, node m's at its first point
+    vector<FieldType> num(k);
+    for (int i = 0; i < k; i++) {
+        num[i] = values[i] * weights[i];
+    }
+    vector<FieldType> next(k);
+    for (int j = 0; j+1 < levels.size(); j++) {
+        for (int m = 0; m < nodeCount(j+1); m++) {
+            int first = m << (j+1);
+            int tl = nodePoints(j, 2*m);
+            if (2*m+1 >= nodeCount(j)) {
+                copy(num.begin() + first, num.begin() + first + tl, next.begin() + first);
+                continue;
+            }
+            // N = N_left M_right + N_right M_left
+            int tr = nodePoints(j, 2*m+1);
+            prod_scratch.resize(tl+tr);
+            prod_scratch2.resize(tl+tr);
+            engine->polyMult(&num[first], tl, node(j, 2*m+1), tr+1, &prod_scratch[0]);
+            engine->polyMult(&num[first+tl], tr, node(j, 2*m), tl+1, &prod_scratch2[0]);
+            for (int i = 0; i < tl+tr; i++) {
+                next[first+i] = prod_scratch[i] + prod_scratch2[i];
+            }
+        }
+        num.swap(next);
+    }
+    return num;
+}
+
+#endif
@@ -131,3 +131,58 @@ ZZ_p TemplateField<ZZ_p>::bytesToElement(unsigned char* elemenetInBytes){
     return to_ZZ_p(zz);
 }
 
+
+
+
+template <>
+TemplateField<ZpFFTElement>::TemplateField(long fieldParam) {
+
+    if (fieldParam != (long) ZpFFTElement::p) {
+        throw std::invalid_argument("ZpFFTElement only supports the field Z_p of size 3193032821761");
+    }
+    this->fieldParam = fieldParam;
+    this->elementSizeInBytes = NumBytes(fieldParam);//round up to the next byte
+    this->elementSizeInBits = this->elementSizeInBytes*8;
+
+    auto randomKey = prg.generateKey(128);
+    prg.setKey(randomKey);
+
+    m_ZERO = new ZpFFTElement(0);
+    m_ONE = new ZpFFTElement(1);
+}
+
+template <>
+ZpFFTElement TemplateField<ZpFFTElement>::GetElement(long b) {
+
+    if(b == 1)
+    {
+        return *m_ONE;
+    }
+    if(b == 0)
+    {
+        return *m_ZERO;
+    }
+    else{
+        ZpFFTElement element(b);
+        return element;
+    }
+}
+
+template <>
+void TemplateField<ZpFFTElement>::elementToBytes(unsigned char* elemenetInBytes, ZpFFTElement& element){
+
+    // little endian, same byte order as BytesFromZZ
+    for (int i = 0; i < elementSizeInBytes; i++) {
+        elemenetInBytes[i] = (unsigned char) (element.elem >> (8*i));
+    }
+}
+
+template <>
+ZpFFTElement TemplateField<ZpFFTElement>::bytesToElement(unsigned char* elemenetInBytes){
+
+    uint64_t b = 0;
+    for (int i = elementSizeInBytes-1; i >= 0; i--) {
+        b = (b << 8) | elemenetInBytes[i];
+    }
+    return ZpFFTElement((long) (b % ZpFFTElement::p));
+}
\ No newline at end of file
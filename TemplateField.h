@@ -13,6 +13,7 @@
 #include <NTL/GF2X.h>
 #include <NTL/ZZ_p.h>
 #include<NTL/GF2XFactoring.h>
+#include "ZpFFTElement.h"
 
 
 
@@ -21,7 +21,7 @@ int main() {
     auto t = 25;//1;//1;
     auto d = t + 2*l -1;
     auto num_parties = 100;//11;//5;
-    OptimizedPSS pss1(l,d,num_parties, field_size, &tempField);
+    OptimizedPSS<ZZ_p> pss1(l,d,num_parties, field_size, &tempField);
    
     int nearest_pow = ceil(log2(num_parties+l));
     /*
@@ -217,5 +217,693 @@ int main() {
              throw invalid_argument("Failed!");
         }
     }
+    cout << "Testing native ZpFFTElement field" << endl;
+    TemplateField<ZpFFTElement> nativeField(field_size);
+    OptimizedPSS<ZpFFTElement> pss2(l,d,num_parties, field_size, &nativeField);
+    // the native field has to produce exactly the same evaluations as ZZ_p
+    vector<ZZ_p> zz_coeff(test_deg);
+    vector<ZpFFTElement> native_coeff(test_deg);
+    for (int i = 0; i < test_deg; i++) {
+        native_coeff[i] = nativeField.Random();
+        zz_coeff[i] = FFTFieldTraits<ZZ_p>::fromWord(&tempField, FFTFieldTraits<ZpFFTElement>::toWord(native_coeff[i]));
+    }
+    pss1.prepareCoeffs(zz_coeff, nearest_pow);
+    pss1.DFT(zz_coeff, nearest_pow);
+    pss2.prepareCoeffs(native_coeff, nearest_pow);
+    pss2.DFT(native_coeff, nearest_pow);
+    for (int i = 0; i < (1 << nearest_pow); i++) {
+        if (FFTFieldTraits<ZZ_p>::toWord(zz_coeff[i]) != FFTFieldTraits<ZpFFTElement>::toWord(native_coeff[i])) {
+            cout << "At position " << i << " ZZ_p gave " << zz_coeff[i] << " but ZpFFTElement gave " << native_coeff[i] << endl;
+            throw std::invalid_argument("ZpFFTElement DFT does not match ZZ_p!");
+        }
+    }
+    // lazy reduction is on by default for the native field, compare with the fully reduced DFT
+    vector<ZpFFTElement> reduced_coeff(native_coeff.begin(), native_coeff.end());
+    vector<ZpFFTElement> lazy_coeff(native_coeff.begin(), native_coeff.end());
+    pss2.lazy_reduction = false;
+    pss2.DFT(reduced_coeff, nearest_pow);
+    pss2.lazy_reduction = true;
+    pss2.DFT(lazy_coeff, nearest_pow);
+    if (reduced_coeff != lazy_coeff) {
+        throw std::invalid_argument("Lazy reduction DFT does not match the fully reduced DFT!");
+    }
+    vector<ZpFFTElement> native_sec;
+    for (int i = 0; i < l; i++) {
+        native_sec.push_back(nativeField.Random());
+    }
+    pss2.setSecrets(native_sec);
+    auto native_pts = pss2.secretShareValues();
+    auto native_recovered = pss2.recoverSS(native_pts);
+    for (int i = 0; i < l; i++) {
+        if (native_recovered[i] != native_sec[i]) {
+            cout << "Error! " << native_recovered[i] << " neq " << native_sec[i] << " at position " << i << endl;
+            throw invalid_argument("Failed!");
+        }
+    }
+    cout << "Success!" << endl;
+    cout << "Testing DFT/InvDFT roundtrip at every size" << endl;
+    // the smaller sizes have no tables until this first use
+    for (int pow_u = 1; pow_u <= nearest_pow; pow_u++) {
+        for (int lazy = 0; lazy < 2; lazy++) {
+            pss2.lazy_reduction = (lazy == 1);
+            vector<ZpFFTElement> orig;
+            for (int i = 0; i < (1 << pow_u); i++) {
+                orig.push_back(nativeField.Random());
+            }
+            vector<ZpFFTElement> round(orig);
+            pss2.DFT(round, pow_u);
+            pss2.InvDFT(round, pow_u, round.size());
+            if (round != orig) {
+                cout << "Roundtrip failed for 2^" << pow_u << endl;
+                throw std::invalid_argument("Incorrect cached twiddles!");
+            }
+        }
+    }
+    pss2.lazy_reduction = true;
+    cout << "Success!" << endl;
+    cout << "Testing truncated DFT" << endl;
+    for (int lazy = 0; lazy < 2; lazy++) {
+        pss2.lazy_reduction = (lazy == 1);
+        vector<ZpFFTElement> full;
+        for (int i = 0; i < (1 << nearest_pow); i++) {
+            full.push_back(nativeField.Random());
+        }
+        vector<ZpFFTElement> truncated(full);
+        vector<int> outputs;
+        for (int i = 0; i < (1 << nearest_pow); i++) {
+            if (rand() % 3 == 0) {
+                outputs.push_back(i);
+            }
+        }
+        pss2.DFT(full, nearest_pow);
+        pss2.DFT(truncated, nearest_pow, outputs);
+        for (int i = 0; i < outputs.size(); i++) {
+            if (truncated[outputs[i]] != full[outputs[i]]) {
+                cout << "Output " << outputs[i] << " differs" << endl;
+                throw std::invalid_argument("Incorrect truncated DFT!");
+            }
+        }
+    }
+    pss2.lazy_reduction = true;
+    cout << "Success!" << endl;
+    cout << "Testing input pruned DFT" << endl;
+    int nonzeros[] = {1, 5, d+1, (1 << nearest_pow-1), (1 << nearest_pow-1)+3, (1 << nearest_pow)};
+    for (int j = 0; j < 6; j++) {
+        for (int lazy = 0; lazy < 2; lazy++) {
+            pss2.lazy_reduction = (lazy == 1);
+            vector<ZpFFTElement> full(1 << nearest_pow);
+            for (int i = 0; i < nonzeros[j]; i++) {
+                full[i] = nativeField.Random();
+            }
+            vector<ZpFFTElement> pruned(full);
+            auto preserved = pss2.PreserveInDFT(full, nearest_pow, nonzeros[j]);
+            pss2.DFT(full, nearest_pow);
+            pss2.PrunedDFT(pruned, nearest_pow, nonzeros[j]);
+            if (pruned != full || preserved != full) {
+                cout << "Pruned DFT with " << nonzeros[j] << " nonzero coefficients differs" << endl;
+                throw std::invalid_argument("Incorrect pruned DFT!");
+            }
+        }
+    }
+    pss2.lazy_reduction = true;
+    cout << "Success!" << endl;
+    cout << "Testing radix-4 DFT against radix-2" << endl;
+    for (int pow_u = 2; pow_u <= nearest_pow; pow_u++) {
+        vector<ZpFFTElement> coeffs(1 << pow_u);
+        vector<int> outputs;
+        for (int i = 0; i < (1 << pow_u); i++) {
+            coeffs[i] = i < (1 << pow_u)/2 + 1 ? nativeField.Random() : nativeField.GetElement(0);
+            if (rand() % 4 == 0) {
+                outputs.push_back(i);
+            }
+        }
+        pss2.radix = NTT_RADIX2;
+        pss2.lazy_reduction = false;
+        vector<ZpFFTElement> expected(coeffs);
+        pss2.DFT(expected, pow_u);
+        pss2.radix = NTT_RADIX4;
+        for (int lazy = 0; lazy < 2; lazy++) {
+            pss2.lazy_reduction = (lazy == 1);
+            vector<ZpFFTElement> full(coeffs), pruned(coeffs), truncated(coeffs);
+            pss2.DFT(full, pow_u);
+            pss2.PrunedDFT(pruned, pow_u, (1 << pow_u)/2 + 1);
+            pss2.DFT(truncated, pow_u, outputs);
+            bool same = full == expected && pruned == expected;
+            for (int i = 0; i < outputs.size(); i++) {
+                same = same && truncated[outputs[i]] == expected[outputs[i]];
+            }
+            if (!same) {
+                cout << "Radix-4 DFT of size 2^" << pow_u << " differs" << endl;
+                throw std::invalid_argument("Incorrect radix-4 DFT!");
+            }
+        }
+    }
+    pss2.lazy_reduction = true;
+    cout << "Success!" << endl;
+    cout << "Testing DFT codelets" << endl;
+    for (int pow_u = min_codelet_log; pow_u <= max_codelet_log; pow_u++) {
+        vector<ZpFFTElement> native_c(1 << pow_u);
+        vector<ZZ_p> zz_c(1 << pow_u);
+        for (int i = 0; i < (1 << pow_u); i++) {
+            native_c[i] = nativeField.Random();
+            zz_c[i] = tempField.Random();
+        }
+        vector<ZpFFTElement> native_loop(native_c);
+        vector<ZZ_p> zz_loop(zz_c);
+        pss1.codelets = false;
+        pss2.codelets = false;
+        pss1.DFT(zz_loop, pow_u);
+        pss2.DFT(native_loop, pow_u);
+        pss1.codelets = true;
+        pss2.codelets = true;
+        auto native_preserved = pss2.PreserveInDFT(native_c, pow_u);
+        pss1.DFT(zz_c, pow_u);
+        pss2.DFT(native_c, pow_u);
+        if (zz_c != zz_loop || native_c != native_loop || native_preserved != native_loop) {
+            cout << "Codelet for 2^" << pow_u << " differs" << endl;
+            throw std::invalid_argument("Incorrect DFT codelet!");
+        }
+    }
+    cout << "Success!" << endl;
+    cout << "Testing batched DFT" << endl;
+    int batch = 13;
+    for (int lazy = 0; lazy < 2; lazy++) {
+        pss2.lazy_reduction = (lazy == 1);
+        vector<ZpFFTElement> interleaved((1 << nearest_pow)*batch);
+        vector<vector<ZpFFTElement> > instances(batch, vector<ZpFFTElement>(1 << nearest_pow));
+        for (int i = 0; i < (1 << nearest_pow); i++) {
+            for (int b = 0; b < batch; b++) {
+                instances[b][i] = nativeField.Random();
+                interleaved[i*batch + b] = instances[b][i];
+            }
+        }
+        pss2.DFTBatch(interleaved, nearest_pow, batch);
+        for (int b = 0; b < batch; b++) {
+            pss2.DFT(instances[b], nearest_pow);
+            for (int i = 0; i < (1 << nearest_pow); i++) {
+                if (interleaved[i*batch + b] != instances[b][i]) {
+                    cout << "Instance " << b << " differs at " << i << endl;
+                    throw std::invalid_argument("Incorrect batched DFT!");
+                }
+            }
+        }
+    }
+    pss2.lazy_reduction = true;
+    cout << "Success!" << endl;
+    cout << "Testing four step DFT" << endl;
+    // the fixed prime tops out at 2^10 points, so force the four step path on small sizes
+    pss2.codelets = false;
+    for (int pow_u = 2; pow_u <= nearest_pow; pow_u++) {
+        vector<ZpFFTElement> direct(1 << pow_u);
+        for (int i = 0; i < (1 << pow_u); i++) {
+            direct[i] = nativeField.Random();
+        }
+        vector<ZpFFTElement> four_step(direct);
+        pss2.DFT(direct, pow_u);
+        int four_step_log = pss2.four_step_log;
+        pss2.four_step_log = 2;
+        pss2.DFT(four_step, pow_u);
+        pss2.four_step_log = four_step_log;
+        if (four_step != direct) {
+            cout << "Four step DFT of size 2^" << pow_u << " differs" << endl;
+            throw std::invalid_argument("Incorrect four step DFT!");
+        }
+    }
+    // a four_step_log below 2 still stops at 2^2 points
+    vector<ZpFFTElement> small_direct(4), small_four_step(4);
+    for (int i = 0; i < 4; i++) {
+        small_direct[i] = small_four_step[i] = nativeField.Random();
+    }
+    pss2.DFT(small_direct, 2);
+    int saved_four_step_log = pss2.four_step_log;
+    pss2.four_step_log = 1;
+    pss2.DFT(small_four_step, 2);
+    pss2.four_step_log = saved_four_step_log;
+    if (small_four_step != small_direct) {
+        throw std::invalid_argument("Incorrect DFT with four_step_log = 1!");
+    }
+    pss2.codelets = true;
+    cout << "Success!" << endl;
+    cout << "Testing multithreaded DFT" << endl;
+    // lower the threshold so the test sizes run on the pool, ZZ_p also checks the
+    // workers get the modulus
+    auto pool = make_shared<NTTThreadPool>(4);
+    pss1.codelets = false;
+    pss2.codelets = false;
+    for (int mode = 0; mode < 3; mode++) {
+        // radix-4, radix-2, four step
+        pss1.radix = pss2.radix = (mode == 1) ? NTT_RADIX2 : NTT_RADIX4;
+        int four_step_log = pss1.four_step_log;
+        for (int pow_u = 2; pow_u <= nearest_pow; pow_u++) {
+            vector<ZpFFTElement> native_c(1 << pow_u);
+            vector<ZZ_p> zz_c(1 << pow_u);
+            for (int i = 0; i < (1 << pow_u); i++) {
+                native_c[i] = nativeField.Random();
+                zz_c[i] = tempField.Random();
+            }
+            vector<ZpFFTElement> native_serial(native_c);
+            vector<ZZ_p> zz_serial(zz_c);
+            pss1.DFT(zz_serial, pow_u);
+            pss2.DFT(native_serial, pow_u);
+            pss1.thread_pool = pss2.thread_pool = pool;
+            pss1.parallel_log = pss2.parallel_log = 2;
+            pss1.four_step_log = pss2.four_step_log = (mode == 2) ? 2 : four_step_log;
+            pss1.DFT(zz_c, pow_u);
+            pss2.DFT(native_c, pow_u);
+            pss1.thread_pool = nullptr;
+            pss2.thread_pool = nullptr;
+            pss1.four_step_log = pss2.four_step_log = four_step_log;
+            if (zz_c != zz_serial || native_c != native_serial) {
+                cout << "Multithreaded DFT of size 2^" << pow_u << " differs in mode " << mode << endl;
+                throw std::invalid_argument("Incorrect multithreaded DFT!");
+            }
+        }
+    }
+    pss1.radix = pss2.radix = NTT_RADIX4;
+    pss1.codelets = true;
+    pss2.codelets = true;
+    cout << "Success!" << endl;
+    cout << "Testing fused convolution" << endl;
+    vector<ZpFFTElement> workspace;
+    int conv_lens[][2] = {{1, 1}, {1, 5}, {2, 2}, {7, 9}, {33, 31}, {d+1, d+1}, {64, 65}};
+    for (int j = 0; j < 7; j++) {
+        vector<ZpFFTElement> a(conv_lens[j][0]), b(conv_lens[j][1]);
+        for (auto& x : a) {
+            x = nativeField.Random();
+        }
+        for (auto& x : b) {
+            x = nativeField.Random();
+        }
+        vector<ZpFFTElement> expected(a.size()+b.size()-1);
+        for (int i = 0; i < a.size(); i++) {
+            for (int k = 0; k < b.size(); k++) {
+                expected[i+k] += a[i]*b[k];
+            }
+        }
+        vector<ZpFFTElement> out, cached_out, a_copy(a);
+        pss2.convolve(a, b, out, workspace);
+        auto cached = pss2.cacheTransform(b, nearest_pow);
+        pss2.convolve(a, cached, cached_out, workspace);
+        pss2.polyMult(a_copy, b);
+        if (out != expected || cached_out != expected || a_copy != expected) {
+            cout << "Convolution of lengths " << a.size() << " and " << b.size() << " differs" << endl;
+            throw std::invalid_argument("Incorrect convolution!");
+        }
+    }
+    cout << "Success!" << endl;
+    cout << "Testing size adaptive polyMult" << endl;
+    // schoolbook, unbalanced, odd Karatsuba splits, DFT, and a product too big for the DFT
+    int mult_lens[][2] = {{3, 40}, {9, 9}, {17, 30}, {47, 48}, {49, 60}, {100, 101}};
+    for (int j = 0; j < 6; j++) {
+        vector<ZZ_p> a(mult_lens[j][0]), b(mult_lens[j][1]);
+        for (auto& x : a) {
+            x = tempField.Random();
+        }
+        for (auto& x : b) {
+            x = tempField.Random();
+        }
+        vector<ZZ_p> expected(a.size()+b.size()-1), out;
+        schoolbookMult(&a[0], a.size(), &b[0], b.size(), &expected[0]);
+        pss1.polyMult(a, b, out);
+        pss1.polyMult(b, a);
+        if (out != expected || b != expected) {
+            cout << "Product of lengths " << a.size() << " and " << mult_lens[j][1] << " differs" << endl;
+            throw std::invalid_argument("Incorrect polyMult!");
+        }
+    }
+    cout << "Success!" << endl;
+    cout << "Testing subproduct tree" << endl;
+    int tree_sizes[] = {1, 2, 7, 37, 100};
+    for (int j = 0; j < 5; j++) {
+        int k = tree_sizes[j];
+        vector<ZZ_p> pts(k);
+        for (int i = 0; i < k; i++) {
+            pts[i] = tempField.GetElement(3*i + 5);
+        }
+        SubproductTree<ZZ_p, FFTFieldTraits<ZZ_p> > tree(&pss1, pts);
+        auto top = tree.root();
+        // f longer than the tree so the top division takes the Newton path
+        vector<ZZ_p> f(3*k + 1);
+        for (auto& x : f) {
+            x = tempField.Random();
+        }
+        auto evals = tree.evaluate(f);
+        for (int i = 0; i < k; i++) {
+            ZZ_p horner = tempField.GetElement(0);
+            ZZ_p root_val = tempField.GetElement(0);
+            for (int c = f.size()-1; c >= 0; c--) {
+                horner = horner*pts[i] + f[c];
+            }
+            for (int c = k; c >= 0; c--) {
+                root_val = root_val*pts[i] + top[c];
+            }
+            if (evals[i] != horner || root_val != tempField.GetElement(0) || top[k] != tempField.GetElement(1)) {
+                cout << "Tree over " << k << " points is wrong at point " << i << endl;
+                throw std::invalid_argument("Incorrect subproduct tree!");
+            }
+        }
+        vector<ZZ_p> low(f.begin(), f.begin() + k);
+        auto values = tree.evaluate(low);
+        if (tree.interpolate(values) != low) {
+            cout << "Interpolation over " << k << " points differs" << endl;
+            throw std::invalid_argument("Incorrect interpolation!");
+        }
+    }
+    cout << "Success!" << endl;
+    cout << "Testing batch inversion" << endl;
+    vector<ZZ_p> to_invert(29);
+    for (auto& x : to_invert) {
+        do {
+            x = tempField.Random();
+        } while (x == tempField.GetElement(0));
+    }
+    vector<ZZ_p> inverted(to_invert);
+    batchInverse(inverted, tempField.GetElement(1));
+    for (int i = 0; i < to_invert.size(); i++) {
+        if (inverted[i] != inv(to_invert[i])) {
+            throw std::invalid_argument("Incorrect batch inversion!");
+        }
+    }
+    // the HIM entries are Lagrange coefficients, beta[0] is one of the alphas
+    int him_n = 6, him_m = 4;
+    HIM<ZZ_p> him(him_m, him_n, &tempField);
+    vector<ZZ_p> alpha(him_n), beta(him_m), x(him_n), y(him_m);
+    for (int j = 0; j < him_n; j++) {
+        alpha[j] = tempField.GetElement(j+1);
+        x[j] = tempField.Random();
+    }
+    for (int i = 0; i < him_m; i++) {
+        beta[i] = tempField.GetElement(i == 0 ? 2 : 10+i);
+    }
+    him.InitHIMByVectors(alpha, beta);
+    him.MatrixMult(x, y);
+    for (int i = 0; i < him_m; i++) {
+        ZZ_p expected = tempField.GetElement(0);
+        for (int j = 0; j < him_n; j++) {
+            ZZ_p lambda = tempField.GetElement(1);
+            for (int k = 0; k < him_n; k++) {
+                if (k != j) {
+                    lambda *= (beta[i] - alpha[k]) / (alpha[j] - alpha[k]);
+                }
+            }
+            expected += lambda * x[j];
+        }
+        if (y[i] != expected) {
+            throw std::invalid_argument("Incorrect HIM!");
+        }
+    }
+    cout << "Success!" << endl;
+    cout << "Testing batched secret sharing" << endl;
+    // every share vector has to lie on one polynomial of degree d through the pack,
+    // recoverSS checks all n-(d+1) redundant shares
+    int share_batch = 7;
+    vector<vector<ZZ_p> > zz_packs(share_batch);
+    for (int b = 0; b < share_batch; b++) {
+        // a short pack and an empty one are padded with random secrets
+        for (int i = 0; i < (b == 0 ? 0 : b == 1 ? l/2 : l); i++) {
+            zz_packs[b].push_back(tempField.Random());
+        }
+    }
+    auto zz_batch_shares = pss1.secretShareBatch(zz_packs);
+    for (int b = 0; b < share_batch; b++) {
+        auto recovered = pss1.recoverSS(zz_batch_shares[b]);
+        for (int i = 0; i < zz_packs[b].size(); i++) {
+            if (recovered[i] != zz_packs[b][i]) {
+                cout << "Pack " << b << " differs at secret " << i << endl;
+                throw invalid_argument("Incorrect batched sharing!");
+            }
+        }
+    }
+    vector<vector<ZpFFTElement> > native_packs(share_batch, vector<ZpFFTElement>(l));
+    for (int b = 0; b < share_batch; b++) {
+        nativeField.Random(&native_packs[b][0], l);
+    }
+    auto by_party = pss2.secretShareBatch(native_packs, true);
+    if (by_party.size() != num_parties) {
+        throw invalid_argument("Batched sharing by party has the wrong shape!");
+    }
+    for (int b = 0; b < share_batch; b++) {
+        vector<ZpFFTElement> party_shares(num_parties);
+        for (int j = 0; j < num_parties; j++) {
+            party_shares[j] = by_party[j][b];
+        }
+        if (pss2.recoverSS(party_shares) != native_packs[b]) {
+            cout << "Pack " << b << " is not recovered" << endl;
+            throw invalid_argument("Incorrect batched sharing!");
+        }
+    }
+    bool caught = false;
+    try {
+        native_packs[0].push_back(nativeField.Random());
+        pss2.secretShareBatch(native_packs);
+    } catch (const invalid_argument&) {
+        caught = true;
+    }
+    if (!caught) {
+        throw invalid_argument("Batched sharing took more than l secrets!");
+    }
+    cout << "Success!" << endl;
+    cout << "Testing batched recovery" << endl;
+    // from all n shares by party, one corrupted share flags only its pack
+    by_party[num_parties-1][2] += nativeField.GetElement(1);
+    vector<bool> batch_valid;
+    native_packs[0].pop_back();
+    auto native_batch_secrets = pss2.recoverBatch(by_party, batch_valid, true);
+    for (int b = 0; b < share_batch; b++) {
+        if (native_batch_secrets[b] != native_packs[b] || batch_valid[b] != (b != 2)) {
+            cout << "Pack " << b << " is not recovered or flagged right" << endl;
+            throw invalid_argument("Incorrect batched recovery!");
+        }
+    }
+    // and from the first d+4 shares of each pack, against recoverSS
+    vector<vector<ZZ_p> > zz_received(share_batch);
+    for (int b = 0; b < share_batch; b++) {
+        zz_received[b].assign(zz_batch_shares[b].begin(), zz_batch_shares[b].begin() + d+4);
+    }
+    zz_received[5][d+1] += tempField.GetElement(1);
+    auto zz_batch_secrets = pss1.recoverBatch(zz_received, batch_valid);
+    for (int b = 0; b < share_batch; b++) {
+        vector<ZZ_p> first_points(zz_received[b].begin(), zz_received[b].begin() + d+1);
+        if (zz_batch_secrets[b] != pss1.recoverSS(first_points) || batch_valid[b] != (b != 5)) {
+            cout << "Pack " << b << " is not recovered or flagged right" << endl;
+            throw invalid_argument("Incorrect batched recovery!");
+        }
+    }
+    cout << "Success!" << endl;
+    cout << "Testing random and zero sharings" << endl;
+    vector<vector<ZpFFTElement> > random_secrets;
+    auto random_shares = pss2.shareRandom(share_batch, &random_secrets);
+    if (pss2.recoverBatch(random_shares, batch_valid) != random_secrets || random_secrets[0] == random_secrets[1]) {
+        throw invalid_argument("Incorrect random sharing!");
+    }
+    for (int b = 0; b < share_batch; b++) {
+        if (!batch_valid[b]) {
+            throw invalid_argument("Random sharing is not of degree d!");
+        }
+    }
+    vector<vector<ZZ_p> > zero_secrets;
+    auto zero_shares = pss1.shareZero(share_batch, &zero_secrets, true);
+    auto zz_zero_recovered = pss1.recoverBatch(zero_shares, batch_valid, true);
+    for (int b = 0; b < share_batch; b++) {
+        if (!batch_valid[b] || zz_zero_recovered[b] != zero_secrets[b] || zero_shares[0][b] == tempField.GetElement(0)) {
+            throw invalid_argument("Incorrect zero sharing!");
+        }
+        for (int i = 0; i < l; i++) {
+            if (zero_secrets[b][i] != tempField.GetElement(0)) {
+                throw invalid_argument("Zero sharing has nonzero secrets!");
+            }
+        }
+    }
+    cout << "Success!" << endl;
+    cout << "Testing coefficient embedding" << endl;
+    auto coeff_shares = pss2.shareCoeffBatch(native_packs, true);
+    coeff_shares[d+3][4] += nativeField.GetElement(1);
+    auto coeff_recovered = pss2.recoverCoeffBatch(coeff_shares, batch_valid, true);
+    for (int b = 0; b < share_batch; b++) {
+        if (coeff_recovered[b] != native_packs[b] || batch_valid[b] != (b != 4)) {
+            cout << "Pack " << b << " is not recovered or flagged right" << endl;
+            throw invalid_argument("Incorrect coefficient embedding!");
+        }
+    }
+    // without check points
+    coeff_shares.resize(d+1);
+    if (pss2.recoverCoeffBatch(coeff_shares, batch_valid, true) != native_packs) {
+        throw invalid_argument("Incorrect coefficient embedding from d+1 shares!");
+    }
+    vector<ZZ_p> zz_coeffs(l);
+    for (int i = 0; i < l; i++) {
+        zz_coeffs[i] = tempField.Random();
+    }
+    auto zz_slots = pss1.coeffsToSlots(zz_coeffs);
+    for (int i = 0; i < l; i++) {
+        ZZ_p value = tempField.GetElement(0);
+        for (int k = l-1; k >= 0; k--) {
+            value = value*pss1.roots[i] + zz_coeffs[k];
+        }
+        if (zz_slots[i] != value) {
+            throw invalid_argument("Incorrect coefficients to slots!");
+        }
+    }
+    if (pss1.slotsToCoeffs(zz_slots) != zz_coeffs || pss2.coeffsToSlots(pss2.slotsToCoeffs(native_packs[1])) != native_packs[1]) {
+        throw invalid_argument("Incorrect slots to coefficients!");
+    }
+    cout << "Success!" << endl;
+    cout << "Testing recovery from any parties" << endl;
+    // every other party from the back and then the first ones, shuffled
+    vector<pair<int, ZZ_p> > responses;
+    for (int j = num_parties-1; j >= 0 && responses.size() < d+3; j -= 2) {
+        responses.push_back(make_pair(j, zz_batch_shares[3][j]));
+    }
+    for (int j = 0; responses.size() < d+3; j += 2) {
+        responses.push_back(make_pair(j, zz_batch_shares[3][j]));
+    }
+    random_shuffle(responses.begin(), responses.end());
+    if (pss1.recoverFromParties(responses) != zz_packs[3]) {
+        throw invalid_argument("Incorrect recovery from any parties!");
+    }
+    responses[d+2].second += tempField.GetElement(1);
+    caught = false;
+    try {
+        pss1.recoverFromParties(responses);
+    } catch (const invalid_argument&) {
+        caught = true;
+    }
+    responses.resize(d+1);
+    if (!caught || pss1.recoverFromParties(responses) != zz_packs[3]) {
+        throw invalid_argument("Incorrect check in recovery from any parties!");
+    }
+    coeff_shares = pss2.shareCoeffBatch(native_packs);
+    vector<pair<int, ZpFFTElement> > native_responses;
+    for (int j = num_parties-1; j >= num_parties-(d+1); j--) {
+        native_responses.push_back(make_pair(j, coeff_shares[6][j]));
+    }
+    if (pss2.recoverFromParties(native_responses, true) != native_packs[6]) {
+        throw invalid_argument("Incorrect coefficient recovery from any parties!");
+    }
+    cout << "Success!" << endl;
+    cout << "Testing cached recovery from a set of parties" << endl;
+    // the last d+3 parties in reverse, by party. the two highest are the checks
+    vector<int> subset;
+    vector<vector<ZpFFTElement> > subset_shares;
+    auto native_shares_batch = pss2.secretShareBatch(native_packs);
+    for (int j = num_parties-1; j >= num_parties-(d+3); j--) {
+        subset.push_back(j);
+        subset_shares.push_back(vector<ZpFFTElement>(share_batch));
+        for (int b = 0; b < share_batch; b++) {
+            subset_shares.back()[b] = native_shares_batch[b][j];
+        }
+    }
+    pss2.subset_cache_max = 1;
+    for (int round = 0; round < 3; round++) {
+        // round 1 evicts the set and round 2 builds it again
+        if (round == 1) {
+            vector<int> other(subset.begin(), subset.end()-1);
+            pss2.recoverSubsetBatch(other, vector<vector<ZpFFTElement> >(subset_shares.begin(), subset_shares.end()-1), batch_valid, true);
+        }
+        subset_shares[0][round] += nativeField.GetElement(1);
+        auto subset_secrets = pss2.recoverSubsetBatch(subset, subset_shares, batch_valid, true);
+        subset_shares[0][round] -= nativeField.GetElement(1);
+        for (int b = 0; b < share_batch; b++) {
+            if (subset_secrets[b] != native_packs[b] || batch_valid[b] != (b != round)) {
+                cout << "Pack " << b << " is not recovered or flagged right in round " << round << endl;
+                throw invalid_argument("Incorrect cached recovery!");
+            }
+        }
+    }
+    auto zz_coeff_shares = pss1.shareCoeffBatch(zz_packs);
+    vector<int> zz_subset;
+    vector<vector<ZZ_p> > zz_subset_shares(share_batch);
+    for (int j = 1; j < num_parties && zz_subset.size() < d+2; j += 2) {
+        zz_subset.push_back(j);
+        for (int b = 0; b < share_batch; b++) {
+            zz_subset_shares[b].push_back(zz_coeff_shares[b][j]);
+        }
+    }
+    auto zz_subset_secrets = pss1.recoverSubsetBatch(zz_subset, zz_subset_shares, batch_valid, false, true);
+    for (int b = 2; b < share_batch; b++) {
+        if (zz_subset_secrets[b] != zz_packs[b] || !batch_valid[b]) {
+            throw invalid_argument("Incorrect cached coefficient recovery!");
+        }
+    }
+    cout << "Success!" << endl;
+    cout << "Testing compile time root tables" << endl;
+    ZpFFTElement w = power(ZpFFTElement(14), (long) ((ZpFFTElement::p - 1) >> zp_root_table_log));
+    ZpFFTElement w_k(1);
+    for (int k = 0; k < (1 << zp_root_table_log); k++) {
+        if (zpRootPower(k) != w_k.elem || zpRootQuotient(k) != ZpFFTElement::shoupQuotient(w_k.elem)) {
+            cout << "Root table entry " << k << " differs" << endl;
+            throw std::invalid_argument("Incorrect root table!");
+        }
+        w_k *= w;
+    }
+    for (int i = 0; i < (1 << nearest_pow); i++) {
+        auto e = i < (1 << nearest_pow-1) ? 2*i : 2*(i - (1 << nearest_pow-1)) + 1;
+        if (pss1.roots[i] != power(pss1.generator, e) || pss2.roots[i] != power(pss2.generator, (long) e)) {
+            cout << "Root " << i << " differs" << endl;
+            throw std::invalid_argument("Incorrect roots!");
+        }
+    }
+    cout << "Success!" << endl;
+    cout << "Testing NTT kernels against the scalar kernels" << endl;
+    cout << "Dispatched kernels: " << zpFFTKernels().name << endl;
+    const ZpFFTKernelTable& scalar = getZpFFTKernels(NTT_SCALAR);
+    NTTKernelISA isas[] = {NTT_AVX2, NTT_AVX512IFMA};
+    for (int j = 0; j < 2; j++) {
+        if (!zpFFTKernelSupported(isas[j])) {
+            cout << "Skipping unsupported kernels " << j << endl;
+            continue;
+        }
+        const ZpFFTKernelTable& kernels = getZpFFTKernels(isas[j]);
+        // odd length to hit the scalar tails, the last entries are p-1 to hit the edges
+        int len = 45;
+        vector<uint64_t> x(len), y(len), w(len);
+        for (int i = 0; i < len; i++) {
+            x[i] = i < len-3 ? nativeField.Random().elem : ZpFFTElement::p-1;
+            y[i] = i < len-3 ? nativeField.Random().elem : ZpFFTElement::p-1;
+            w[i] = i < len-3 ? nativeField.Random().elem : ZpFFTElement::p-1;
+        }
+        vector<uint64_t> x2(x), y2(y), a(x), a2(x);
+        scalar.butterfly(&x[0], &y[0], &w[0], len);
+        kernels.butterfly(&x2[0], &y2[0], &w[0], len);
+        scalar.pointwiseMult(&a[0], &w[0], len);
+        kernels.pointwiseMult(&a2[0], &w[0], len);
+        // the lazy kernels have to agree on the unreduced values too, x and y are in [0, 4p) by now
+        vector<uint64_t> wq(len);
+        for (int i = 0; i < len; i++) {
+            wq[i] = ZpFFTElement::shoupQuotient(w[i]);
+            x[i] += 2*ZpFFTElement::p;
+            x2[i] += 2*ZpFFTElement::p;
+        }
+        scalar.lazyButterfly(&x[0], &y[0], &w[0], &wq[0], len);
+        kernels.lazyButterfly(&x2[0], &y2[0], &w[0], &wq[0], len);
+        scalar.normalize(&y[0], len);
+        kernels.normalize(&y2[0], len);
+        // decimation in frequency kernels, y is reduced and x is in [0, 4p)
+        scalar.normalize(&x[0], len);
+        kernels.normalize(&x2[0], len);
+        vector<uint64_t> gx(x), gy(y), gx2(x), gy2(y);
+        scalar.gsButterfly(&gx[0], &gy[0], &w[0], len);
+        kernels.gsButterfly(&gx2[0], &gy2[0], &w[0], len);
+        scalar.lazyGSButterfly(&x[0], &y[0], &w[0], &wq[0], len);
+        kernels.lazyGSButterfly(&x2[0], &y2[0], &w[0], &wq[0], len);
+        // radix-4 over four quarters of length len/4, on the reduced a and gx
+        int q = len/4;
+        vector<uint64_t> r(a), r2(a);
+        scalar.radix4Butterfly(&r[0], &r[q], &r[2*q], &r[3*q], &w[0], &w[q], &w[2*q], q);
+        kernels.radix4Butterfly(&r2[0], &r2[q], &r2[2*q], &r2[3*q], &w[0], &w[q], &w[2*q], q);
+        vector<uint64_t> lr(gx), lr2(gx);
+        scalar.lazyRadix4Butterfly(&lr[0], &lr[q], &lr[2*q], &lr[3*q], &w[0], &w[q], &w[2*q], &wq[0], &wq[q], &wq[2*q], q);
+        kernels.lazyRadix4Butterfly(&lr2[0], &lr2[q], &lr2[2*q], &lr2[3*q], &w[0], &w[q], &w[2*q], &wq[0], &wq[q], &wq[2*q], q);
+        vector<uint64_t> bx(a), by(gx), bx2(a), by2(gx);
+        scalar.broadcastButterfly(&bx[0], &by[0], w[3], len);
+        kernels.broadcastButterfly(&bx2[0], &by2[0], w[3], len);
+        scalar.lazyBroadcastButterfly(&bx[0], &by[0], w[5], wq[5], len);
+        kernels.lazyBroadcastButterfly(&bx2[0], &by2[0], w[5], wq[5], len);
+        if (x != x2 || y != y2 || a != a2 || gx != gx2 || gy != gy2 || r != r2 || lr != lr2 || bx != bx2 || by != by2) {
+            cout << "Kernels " << kernels.name << " differ from the scalar kernels" << endl;
+            throw std::invalid_argument("Incorrect NTT kernels!");
+        }
+    }
+    cout << "Success!" << endl;
     cout << "Passed tests!" << endl;
 }
@@ -0,0 +1,155 @@
+// becgabri (10/17/2026)
+
+#ifndef ZPFFTELEMENT_H
+#define ZPFFTELEMENT_H
+
+#include <stdint.h>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+// A native, word-sized element of Z_p for the prime OptimizedPSS is built around
+// p = 3193032821761 = 2^10 * 3^3 * 5 * 19 * 173 * 7027 + 1
+// p has 42 bits, so the product of two elements fits in an unsigned __int128 and is
+// brought back into [0, p) with a Barrett reduction. Elements are always stored
+// in canonical form so comparison, printing and serialization need no conversion.
+class ZpFFTElement {
+public:
+    static const uint64_t p = 3193032821761ULL;
+    static const int p_bits = 42;
+    // floor(2^84 / p), the Barrett constant for products < p^2 < 2^84
+    static const uint64_t barrett_mu = 6057818442081ULL;
+
+    uint64_t elem;
+
+    ZpFFTElement() : elem(0) {}
+    ZpFFTElement(long b) {
+        long r = b % (long) p;
+        elem = (r < 0) ? (uint64_t) (r + (long) p) : (uint64_t) r;
+    }
+
+    // reduce t < 2^84 into [0, p)
+    static inline uint64_t reduce(unsigned __int128 t) {
+        uint64_t q = (uint64_t) ((((unsigned __int128) (uint64_t) (t >> (p_bits-1))) * barrett_mu) >> (p_bits+1));
+        uint64_t r = (uint64_t) t - q*p;
+        // q is at most 2 less than the true quotient. the corrections are done
+        // with masks, a data dependent branch here mispredicts constantly
+        r -= p & (0 - (uint64_t) (r >= p));
+        r -= p & (0 - (uint64_t) (r >= p));
+        return r;
+    }
+
+    static inline uint64_t mulMod(uint64_t a, uint64_t b) {
+        return reduce((unsigned __int128) a * b);
+    }
+
+    // Shoup's precomputed quotient floor(w * 2^52 / p) for a fixed multiplicand w < p
+    static inline uint64_t shoupQuotient(uint64_t w) {
+        return (uint64_t) ((((unsigned __int128) w) << 52) / p);
+    }
+
+    // w*y mod p up to one extra p, i.e. the result is in [0, 2p). only needs y < 2^52
+    // so it accepts the unreduced values of the lazy transforms
+    static inline uint64_t mulShoupLazy(uint64_t w, uint64_t wq, uint64_t y) {
+        uint64_t q = (uint64_t) (((unsigned __int128) wq * y) >> 52);
+        return w*y - q*p;
+    }
+
+    static inline ZpFFTElement fromCanonical(uint64_t v) {
+        ZpFFTElement e;
+        e.elem = v;
+        return e;
+    }
+
+    bool operator==(const ZpFFTElement& other) const { return elem == other.elem; }
+    bool operator!=(const ZpFFTElement& other) const { return elem != other.elem; }
+
+    static inline uint64_t addMod(uint64_t a, uint64_t b) {
+        uint64_t s = a + b;
+        return s - (p & (0 - (uint64_t) (s >= p)));
+    }
+
+    static inline uint64_t subMod(uint64_t a, uint64_t b) {
+        return a - b + (p & (0 - (uint64_t) (a < b)));
+    }
+
+    ZpFFTElement operator+(const ZpFFTElement& other) const {
+        return fromCanonical(addMod(elem, other.elem));
+    }
+
+    ZpFFTElement operator-(const ZpFFTElement& other) const {
+        return fromCanonical(subMod(elem, other.elem));
+    }
+
+    ZpFFTElement operator-() const {
+        return fromCanonical(elem == 0 ? 0 : p - elem);
+    }
+
+    ZpFFTElement operator*(const ZpFFTElement& other) const {
+        return fromCanonical(mulMod(elem, other.elem));
+    }
+
+    ZpFFTElement operator/(const ZpFFTElement& other) const;
+
+    ZpFFTElement& operator+=(const ZpFFTElement& other) { *this = *this + other; return *this; }
+    ZpFFTElement& operator-=(const ZpFFTElement& other) { *this = *this - other; return *this; }
+    ZpFFTElement& operator*=(const ZpFFTElement& other) { elem = mulMod(elem, other.elem); return *this; }
+    ZpFFTElement& operator/=(const ZpFFTElement& other) { *this = *this / other; return *this; }
+};
+
+// mirrors NTL's power(ZZ_p, long) so templated code can use either type
+inline ZpFFTElement power(const ZpFFTElement& a, long e) {
+    if (e < 0) {
+        throw invalid_argument("ZpFFTElement: negative exponents are not supported");
+    }
+    ZpFFTElement result(1);
+    uint64_t base = a.elem;
+    while (e > 0) {
+        if (e & 1) {
+            result.elem = ZpFFTElement::mulMod(result.elem, base);
+        }
+        base = ZpFFTElement::mulMod(base, base);
+        e >>= 1;
+    }
+    return result;
+}
+
+// extended euclid, much cheaper than a^(p-2)
+inline ZpFFTElement inv(const ZpFFTElement& a) {
+    if (a.elem == 0) {
+        throw invalid_argument("ZpFFTElement: trying to invert zero");
+    }
+    int64_t t = 0, new_t = 1;
+    int64_t r = (int64_t) ZpFFTElement::p, new_r = (int64_t) a.elem;
+    while (new_r != 0) {
+        int64_t q = r / new_r;
+        int64_t tmp = t - q*new_t;
+        t = new_t;
+        new_t = tmp;
+        tmp = r - q*new_r;
+        r = new_r;
+        new_r = tmp;
+    }
+    if (t < 0) {
+        t += (int64_t) ZpFFTElement::p;
+    }
+    return ZpFFTElement::fromCanonical((uint64_t) t);
+}
+
+inline ZpFFTElement ZpFFTElement::operator/(const ZpFFTElement& other) const {
+    return *this * inv(other);
+}
+
+inline ostream& operator<<(ostream& s, const ZpFFTElement& a) {
+    return s << a.elem;
+}
+
+inline istream& operator>>(istream& s, ZpFFTElement& a) {
+    long b;
+    s >> b;
+    a = ZpFFTElement(b);
+    return s;
+}
+
+#endif
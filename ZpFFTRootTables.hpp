@@ -0,0 +1,93 @@
+// becgabri (10/17/2026)
+
+#ifndef ZPFFTROOTTABLES_H
+#define ZPFFTROOTTABLES_H
+
+#include "ZpFFTElement.h"
+#include <stdint.h>
+
+using namespace std;
+
+// Powers of the primitive 2^10-th root of unity w = 14^((p-1)/2^10) for the fixed
+// prime p = 3193032821761, worked out by the compiler. The primitive 2^k-th root
+// that FFTFieldTraits hands out is w^(2^(10-k)), so every root, evaluation point and
+// twiddle an OptimizedPSS over this prime needs is an entry of this table
+static const int zp_root_table_log = 10;
+
+constexpr uint64_t zpMulModConst(uint64_t a, uint64_t b) {
+    return (uint64_t) (((unsigned __int128) a * b) % ZpFFTElement::p);
+}
+
+constexpr uint64_t zpPowModConst(uint64_t b, uint64_t e) {
+    return e == 0 ? 1
+         : (e & 1) ? zpMulModConst(b, zpPowModConst(b, e-1))
+         : zpPowModConst(zpMulModConst(b, b), e >> 1);
+}
+
+// same as ZpFFTElement::shoupQuotient
+constexpr uint64_t zpShoupConst(uint64_t w) {
+    return (uint64_t) ((((unsigned __int128) w) << 52) / ZpFFTElement::p);
+}
+
+constexpr uint64_t zp_table_root = zpPowModConst(14, (ZpFFTElement::p - 1) >> zp_root_table_log);
+
+static_assert(zpPowModConst(zp_table_root, 1 << (zp_root_table_log-1)) == ZpFFTElement::p - 1,
+              "14 does not give a primitive 2^10-th root of unity");
+
+// 0 ... N-1 as a parameter pack, N a power of two, built by doubling so the
+// template depth stays at log N
+template <int... I>
+struct ZpRootIndices {};
+
+template <class A, class B>
+struct ZpConcatRootIndices;
+
+template <int... I, int... J>
+struct ZpConcatRootIndices<ZpRootIndices<I...>, ZpRootIndices<J...> > {
+    typedef ZpRootIndices<I..., (int) sizeof...(I) + J...> type;
+};
+
+template <int N>
+struct ZpMakeRootIndices {
+    typedef typename ZpMakeRootIndices<N/2>::type half;
+    typedef typename ZpConcatRootIndices<half, half>::type type;
+};
+
+template <>
+struct ZpMakeRootIndices<1> {
+    typedef ZpRootIndices<0> type;
+};
+
+template <class Indices>
+struct ZpRootTable;
+
+template <int... I>
+struct ZpRootTable<ZpRootIndices<I...> > {
+    static constexpr uint64_t powers[sizeof...(I)] = {zpPowModConst(zp_table_root, I)...};
+    static constexpr uint64_t quotients[sizeof...(I)] = {zpShoupConst(zpPowModConst(zp_table_root, I))...};
+};
+
+template <int... I>
+constexpr uint64_t ZpRootTable<ZpRootIndices<I...> >::powers[sizeof...(I)];
+
+template <int... I>
+constexpr uint64_t ZpRootTable<ZpRootIndices<I...> >::quotients[sizeof...(I)];
+
+typedef ZpRootTable<ZpMakeRootIndices<1 << zp_root_table_log>::type> ZpRoots;
+
+// w^e for any e, negative exponents included since w^(2^10) = 1
+inline uint64_t zpRootPower(long e) {
+    return ZpRoots::powers[e & ((1 << zp_root_table_log) - 1)];
+}
+
+// the Shoup quotient of w^e
+inline uint64_t zpRootQuotient(long e) {
+    return ZpRoots::quotients[e & ((1 << zp_root_table_log) - 1)];
+}
+
+// 1/2^k = -(p-1)/2^k
+constexpr uint64_t zpInverseTwoPower(int k) {
+    return ZpFFTElement::p - ((ZpFFTElement::p - 1) >> k);
+}
+
+#endif
@@ -0,0 +1,44 @@
+// becgabri (10/17/2026)
+
+#ifndef LIBSCAPI_BATCHINVERSE_H
+#define LIBSCAPI_BATCHINVERSE_H
+
+#include <vector>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * Montgomery's trick: replaces values[0 ... count) by their inverses with one field
+ * inversion and 3(count-1) multiplications. The running products a_0 ... a_i are
+ * kept, (a_0 ... a_{count-1})^-1 is inverted once, and walking back down each
+ * inverse is the running inverse times the product before it.
+ * Every value must be nonzero, a zero makes the one inversion fail.
+ */
+template <typename FieldType>
+void batchInverse(FieldType* values, int count, const FieldType& one)
+{
+    if (count <= 0) {
+        return;
+    }
+    vector<FieldType> prefix(count);
+    prefix[0] = values[0];
+    for (int i = 1; i < count; i++) {
+        prefix[i] = prefix[i-1] * values[i];
+    }
+    FieldType running = one / prefix[count-1];
+    for (int i = count-1; i > 0; i--) {
+        FieldType inverse = running * prefix[i-1];
+        running *= values[i];
+        values[i] = inverse;
+    }
+    values[0] = running;
+}
+
+template <typename FieldType>
+void batchInverse(vector<FieldType>& values, const FieldType& one)
+{
+    batchInverse(values.data(), (int) values.size(), one);
+}
+
+#endif
@@ -15,6 +15,7 @@
 #include <vector>
 #include <array>
 #include "Mersenne.hpp"
+#include "BatchInverse.hpp"
 
 
 
@@ -117,26 +118,40 @@ void HIM<FieldType>::InitHIMByVectors(vector<FieldType> &alpha, vector<FieldType
 
     int m = beta.size();
     int n = alpha.size();
-    for (int i = 0; i < m; i++)
+    FieldType one = *(field->GetOne());
+
+    // matrix[i,j] = prod_{k != j} (beta_i - alpha_k) / prod_{k != j} (alpha_j - alpha_k).
+    // the n denominators don't depend on i, they are inverted once as a batch
+    vector<FieldType> denominator(n);
+    for (int j = 0; j < n; j++)
     {
-        for (int j = 0; j < n; j++)
+        denominator[j] = one;
+        for (int k = 0; k < n; k++)
         {
-            // lambda = 1
-            lambda = *(field->GetOne());
-
-            // compute value for matrix[i,j]
-            for (int k = 0; k < n; k++)
+            if (k != j)
             {
-                if (k == j)
-                {
-                    continue;
-                }
-
-                lambda *= ((beta[i]) - (alpha[k])) / ((alpha[j]) - (alpha[k]));
+                denominator[j] *= (alpha[j]) - (alpha[k]);
             }
+        }
+    }
+    batchInverse(denominator, one);
 
+    // prod_{k != j} (beta_i - alpha_k) = (product of the terms before j) * (product of
+    // the terms after j), no division even when beta_i is one of the alphas
+    vector<FieldType> suffix(n+1);
+    for (int i = 0; i < m; i++)
+    {
+        suffix[n] = one;
+        for (int k = n-1; k >= 0; k--)
+        {
+            suffix[k] = suffix[k+1] * ((beta[i]) - (alpha[k]));
+        }
+        lambda = one;
+        for (int j = 0; j < n; j++)
+        {
             // set the matrix
-            (*m_matrix)[i][j] = lambda;
+            (*m_matrix)[i][j] = lambda * suffix[j+1] * denominator[j];
+            lambda *= (beta[i]) - (alpha[j]);
         }
     }
     return;
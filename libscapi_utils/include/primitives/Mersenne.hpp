@@ -63,6 +63,8 @@ public:
      */
     FieldType GetElement(long b);
     FieldType Random();
+    // count random elements into out, one prg call each with the size test done once
+    void Random(FieldType* out, int count);
     ~TemplateField();
 
 };
@@ -104,6 +106,20 @@ FieldType TemplateField<FieldType>::Random() {
     return GetElement(b);
 }
 
+template <class FieldType>
+void TemplateField<FieldType>::Random(FieldType* out, int count) {
+    if (elementSizeInBytes <= 4) {
+        for (int i = 0; i < count; i++) {
+            out[i] = GetElement(prg.getRandom32());
+        }
+    } else {
+        int shift = 64 - elementSizeInBits;
+        for (int i = 0; i < count; i++) {
+            out[i] = GetElement(prg.getRandom64() >> shift);
+        }
+    }
+}
+
 template <class FieldType>
 FieldType* TemplateField<FieldType>::GetZero()
 {